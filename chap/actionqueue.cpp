@@ -0,0 +1,147 @@
+#include "actionqueue.h"
+
+ActionQueue::ActionQueue(const QString &name, Runner runner, QObject *parent)
+    : QObject{parent}
+    , m_name(name)
+    , m_runner(std::move(runner))
+    , m_timer(new QTimer(this))
+    , m_clock()
+    , m_items()
+    , m_busyUntil(0)
+    , m_depth(0)
+    , m_lastWait(0)
+    , m_online(false)
+    , m_policy(Sequential)
+    , m_minGap(0)
+    , m_maxDuration(0)
+    , m_maxDepth(DefaultMaxDepth)
+    , m_maxWait(DefaultMaxWait)
+{
+    m_clock.start();
+    connect(m_timer, &QTimer::timeout, this, &ActionQueue::process);
+    m_timer->setSingleShot(true);
+    // anything held back for an offline device can go as soon as it's back
+    connect(this, &ActionQueue::onlineChanged, this, [this]() { schedule(); });
+}
+
+qint64 ActionQueue::oldestWait() const
+{
+    return m_items.empty() ? 0 : m_clock.elapsed() - m_items.front().queuedAt;
+}
+
+bool ActionQueue::enqueue(const QList<QString> &redemptionIds, const int &duration)
+{
+    Item item{redemptionIds, qMax(0, duration), m_clock.elapsed()};
+    if (static_cast<int>(m_items.size()) >= m_maxDepth) {
+        drop(item, u"queue full"_qs);
+        return false;
+    }
+    m_items.push_back(std::move(item));
+    setDepth(static_cast<int>(m_items.size()));
+    schedule();
+    return true;
+}
+
+void ActionQueue::clear()
+{
+    while (!m_items.empty()) {
+        drop(m_items.front(), u"cleared"_qs);
+        m_items.pop_front();
+    }
+    setDepth(0);
+    m_timer->stop();
+}
+
+void ActionQueue::process()
+{
+    const qint64 now = m_clock.elapsed();
+    expire(now);
+    if (m_items.empty()) {
+        return;
+    }
+    if (!m_online) {
+        m_timer->start(OfflineRetryInterval);
+        return;
+    }
+    if (now < m_busyUntil) {
+        schedule();
+        return;
+    }
+
+    setLastWait(static_cast<int>(now - m_items.front().queuedAt));
+    QList<QString> ids;
+    int duration = 0;
+    switch (m_policy) {
+    case Coalesce: {
+        for (const Item &item : m_items) {
+            ids.append(item.redemptionIds);
+            duration = qMax(duration, item.duration);
+        }
+        m_items.clear();
+        break;
+    }
+    case ExtendDuration: {
+        // always take at least one, even if it alone is over the max
+        do {
+            const Item &item = m_items.front();
+            ids.append(item.redemptionIds);
+            duration += item.duration;
+            m_items.pop_front();
+        } while (!m_items.empty() &&
+                 (m_maxDuration <= 0 || duration + m_items.front().duration <= m_maxDuration));
+        break;
+    }
+    default: {
+        ids = m_items.front().redemptionIds;
+        duration = m_items.front().duration;
+        m_items.pop_front();
+        break;
+    }
+    }
+    if (m_maxDuration > 0) {
+        duration = qMin(duration, m_maxDuration);
+    }
+    setDepth(static_cast<int>(m_items.size()));
+
+    m_busyUntil = now + duration * 1000 + m_minGap;
+    qDebug() << "Running" << m_name << "for" << ids.size() << "redemptions," << duration
+             << "secs," << m_depth << "still waiting";
+    m_runner(ids, duration);
+    emit executed(ids, duration);
+    schedule();
+}
+
+void ActionQueue::expire(const qint64 &now)
+{
+    if (m_maxWait <= 0) {
+        return;
+    }
+    bool changed = false;
+    while (!m_items.empty() && now - m_items.front().queuedAt > m_maxWait) {
+        drop(m_items.front(), u"waited too long"_qs);
+        m_items.pop_front();
+        changed = true;
+    }
+    if (changed) {
+        setDepth(static_cast<int>(m_items.size()));
+    }
+}
+
+void ActionQueue::schedule()
+{
+    if (m_items.empty()) {
+        m_timer->stop();
+        return;
+    }
+    const qint64 delay = qMax<qint64>(0, m_busyUntil - m_clock.elapsed());
+    // an earlier wake up is never wrong, process() checks again anyway
+    if (!m_timer->isActive() || m_timer->remainingTime() > delay) {
+        m_timer->start(static_cast<int>(delay));
+    }
+}
+
+void ActionQueue::drop(const Item &item, const QString &reason)
+{
+    qWarning() << "Dropping" << m_name << "for" << item.redemptionIds << reason;
+    emit dropped(item.redemptionIds, reason);
+}
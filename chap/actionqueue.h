@@ -0,0 +1,102 @@
+#ifndef ACTIONQUEUE_H
+#define ACTIONQUEUE_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+#include <deque>
+#include <functional>
+
+#include "qmlsupport.h"
+#include "qtutils.h"
+
+/* Lines up the redemptions for a single device.
+ *
+ * A device only does one thing at a time, the smoke machine outright ignores
+ * an activate while it's running, so every run is followed by a busy period
+ * of its duration plus a minimum gap and nothing else is sent until that is
+ * over. The policy decides what the next run is made of:
+ *
+ *  Coalesce        everything waiting goes in one run, longest duration wins
+ *  Sequential      one run per redemption
+ *  ExtendDuration  everything waiting goes in one run with the durations
+ *                  added up, split into more runs past the max duration
+ *
+ * Nothing is lost quietly, every redemption is either executed or dropped,
+ * when the queue is full or it waited longer than the max wait, and both are
+ * reported so the caller can settle it with twitch.
+ */
+class ActionQueue : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Backend only.")
+
+  public:
+    enum Policy {
+        Coalesce,
+        Sequential,
+        ExtendDuration,
+    };
+    Q_ENUM(Policy)
+
+    // runs the device once for these redemptions, duration in seconds
+    using Runner = std::function<void(const QList<QString> &redemptionIds, int duration)>;
+
+    // plenty for any backlog a stream could build up
+    inline const static int DefaultMaxDepth{100};
+    // redemptions older than this are dropped instead of run, msecs
+    inline const static int DefaultMaxWait{5 * 60 * 1000};
+    // how often an offline device is checked on again, msecs
+    inline const static int OfflineRetryInterval{1000};
+
+    explicit ActionQueue(const QString &name, Runner runner, QObject *parent = nullptr);
+
+    // how long the oldest waiting redemption has been waiting, msecs
+    Q_INVOKABLE qint64 oldestWait() const;
+
+  signals:
+    void executed(const QList<QString> &redemptionIds, int duration);
+    void dropped(const QList<QString> &redemptionIds, const QString &reason);
+
+  public slots:
+    // false if it was dropped right away because the queue is full
+    bool enqueue(const QList<QString> &redemptionIds, const int &duration = 0);
+    void clear();
+
+  private slots:
+    void process();
+
+  private:
+    struct Item {
+        QList<QString> redemptionIds;
+        int duration = 0;
+        qint64 queuedAt = 0;
+    };
+
+    QString m_name;
+    Runner m_runner;
+    QTimer *m_timer;
+    QElapsedTimer m_clock;
+    std::deque<Item> m_items;
+    qint64 m_busyUntil;
+
+    void expire(const qint64 &now);
+    void schedule();
+    void drop(const Item &item, const QString &reason);
+
+    RO_PROP(int, depth, setDepth)
+    // time the last run's first redemption spent waiting, msecs
+    RO_PROP(int, lastWait, setLastWait)
+    RW_PROP(bool, online, setOnline)
+    RW_PROP(Policy, policy, setPolicy)
+    // between the end of one run and the start of the next, msecs
+    RW_PROP(int, minGap, setMinGap)
+    // longest a single run may be, seconds
+    RW_PROP(int, maxDuration, setMaxDuration)
+    RW_PROP(int, maxDepth, setMaxDepth)
+    RW_PROP(int, maxWait, setMaxWait)
+};
+
+#endif // ACTIONQUEUE_H
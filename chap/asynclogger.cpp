@@ -0,0 +1,320 @@
+#include "asynclogger.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QtEndian>
+
+#include <cstdio>
+#include <cstring>
+
+#include "qtutils.h"
+
+static std::atomic<AsyncLogger *> logger{nullptr};
+
+static const char *typeName(const QtMsgType &type)
+{
+    switch (type) {
+    case QtDebugMsg:
+        return "DBUG";
+    case QtInfoMsg:
+        return "INFO";
+    case QtWarningMsg:
+        return "WARN";
+    case QtCriticalMsg:
+        return "CRIT";
+    case QtFatalMsg:
+        return "FATL";
+    }
+    return "????";
+}
+
+// the same "[time] TYPE: message" line messageHandler() prints
+static QByteArray textLine(const qint64 &msecs, const QtMsgType &type, const QByteArray &text)
+{
+    QByteArray line = QDateTime::fromMSecsSinceEpoch(msecs).toString(Qt::ISODateWithMs).toLatin1();
+    line.prepend('[');
+    line.append("] ").append(typeName(type)).append(": ").append(text).append('\n');
+    return line;
+}
+
+AsyncLogger::AsyncLogger()
+    : m_slots(new Slot[Capacity])
+    , m_head(0)
+    , m_tail(0)
+    , m_dropped(0)
+    , m_reportedDropped(0)
+    , m_stopping(false)
+    , m_wake()
+    , m_drainLock()
+    , m_file()
+    , m_maxBytes(0)
+    , m_binary(false)
+    , m_writer()
+{
+    for (quint64 i = 0; i < Capacity; i++) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    m_writer = std::thread([this]() { run(); });
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    // anything logged from here on goes straight out
+    qInstallMessageHandler(messageHandler);
+    logger = nullptr;
+    m_stopping = true;
+    m_wake.release();
+    m_writer.join();
+}
+
+void AsyncLogger::install()
+{
+    static AsyncLogger instance;
+    logger = &instance;
+    qInstallMessageHandler(handler);
+}
+
+bool AsyncLogger::logToFile(const QString &path, const qint64 &maxBytes, bool binary)
+{
+    AsyncLogger *current = logger;
+    if (!current) {
+        return false;
+    }
+    QMutexLocker lock(&current->m_drainLock);
+    current->m_maxBytes = maxBytes;
+    current->m_binary = binary;
+    return current->openFile(path);
+}
+
+quint64 AsyncLogger::dropped()
+{
+    AsyncLogger *current = logger;
+    return current ? current->m_dropped.load(std::memory_order_relaxed) : 0;
+}
+
+QByteArray AsyncLogger::decode(const QByteArray &binary)
+{
+    if (!binary.startsWith(BinaryMagic)) {
+        return {};
+    }
+    QByteArray out;
+    qsizetype pos = BinaryMagic.size();
+    while (pos + RecordHeader <= binary.size()) {
+        const char *data = binary.constData() + pos;
+        const qint64 msecs = qFromLittleEndian<qint64>(data);
+        const QtMsgType type = static_cast<QtMsgType>(static_cast<quint8>(data[8]));
+        const quint16 length = qFromLittleEndian<quint16>(data + 9);
+        pos += RecordHeader;
+        // a line cut off by a crash mid write, nothing after it is usable
+        if (pos + length > binary.size()) {
+            break;
+        }
+        out += textLine(msecs, type, binary.mid(pos, length));
+        pos += length;
+    }
+    return out;
+}
+
+void AsyncLogger::handler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+#ifndef QT_DEBUG
+    if (type == QtDebugMsg) {
+        return;
+    }
+#endif
+    // ignore some noisy ios platform warnings
+    if (type == QtWarningMsg && msg.contains(u"focus object"_qs)) {
+        return;
+    }
+    AsyncLogger *current = logger;
+    if (!current) {
+        messageHandler(type, context, msg);
+        return;
+    }
+    current->push(type, msg);
+    if (type != QtFatalMsg) {
+        return;
+    }
+    // there is no coming back from this one, get everything out first
+    current->drain();
+    QCoreApplication *app = QCoreApplication::instance();
+    if (app != nullptr) {
+        app->exit(-1);
+    } else {
+        abort();
+    }
+}
+
+bool AsyncLogger::push(const QtMsgType &type, const QString &msg)
+{
+    // a bounded ring where each slot's sequence says whose turn it is: equal
+    // to the position it is free for a producer, one past it has a line for
+    // the writer, anything behind means the writer hasn't caught up yet
+    quint64 pos = m_head.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+    for (;;) {
+        slot = &m_slots[pos & (Capacity - 1)];
+        const quint64 sequence = slot->sequence.load(std::memory_order_acquire);
+        const qint64 diff = static_cast<qint64>(sequence - pos);
+        if (diff == 0) {
+            if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = m_head.load(std::memory_order_relaxed);
+        }
+    }
+
+    Record &record = slot->record;
+    record.msecs = QDateTime::currentMSecsSinceEpoch();
+    record.type = type;
+    const QByteArray utf8 = msg.toUtf8();
+    qsizetype length = qMin<qsizetype>(utf8.size(), MaxLine);
+    // don't leave half a character behind when cutting it short
+    if (length < utf8.size()) {
+        while (length > 0 && (utf8[length] & 0xc0) == 0x80) {
+            length--;
+        }
+    }
+    std::memcpy(record.text, utf8.constData(), length);
+    record.length = static_cast<quint16>(length);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    // warnings shouldn't sit around, and a burst shouldn't fill the ring
+    // while the writer is still waiting out the interval
+    if (type != QtDebugMsg && type != QtInfoMsg) {
+        m_wake.release();
+    } else if ((pos & (Capacity / 2 - 1)) == 0) {
+        m_wake.release();
+    }
+    return true;
+}
+
+void AsyncLogger::run()
+{
+    while (!m_stopping) {
+        m_wake.tryAcquire(1, FlushInterval);
+        drain();
+    }
+    drain();
+}
+
+void AsyncLogger::drain()
+{
+    QMutexLocker lock(&m_drainLock);
+    QByteArray out, err, file;
+    for (;;) {
+        Slot &slot = m_slots[m_tail & (Capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != m_tail + 1) {
+            break;
+        }
+        write(slot.record, out, err, file);
+        // free for whoever claims this position on the next lap
+        slot.sequence.store(m_tail + Capacity, std::memory_order_release);
+        m_tail++;
+    }
+
+    const quint64 dropped = m_dropped.load(std::memory_order_relaxed);
+    if (dropped != m_reportedDropped) {
+        append(QDateTime::currentMSecsSinceEpoch(), QtWarningMsg,
+               "Logging fell behind, dropped " +
+                   QByteArray::number(dropped - m_reportedDropped) + " lines",
+               out, err, file);
+        m_reportedDropped = dropped;
+    }
+
+    if (!out.isEmpty()) {
+        fwrite(out.constData(), 1, out.size(), stdout);
+        fflush(stdout);
+    }
+    if (!err.isEmpty()) {
+        fwrite(err.constData(), 1, err.size(), stderr);
+        fflush(stderr);
+    }
+    if (!file.isEmpty()) {
+        writeFile(file);
+    }
+}
+
+void AsyncLogger::write(const Record &record, QByteArray &out, QByteArray &err,
+                        QByteArray &file) const
+{
+    append(record.msecs, record.type, QByteArray::fromRawData(record.text, record.length), out,
+           err, file);
+}
+
+void AsyncLogger::append(const qint64 &msecs, const QtMsgType &type, const QByteArray &text,
+                         QByteArray &out, QByteArray &err, QByteArray &file) const
+{
+    const QByteArray line = textLine(msecs, type, text);
+    QByteArray &console = type == QtDebugMsg || type == QtInfoMsg ? out : err;
+#ifdef Q_OS_WIN
+    console += QString::fromUtf8(line).toLocal8Bit();
+#else
+    console += line;
+#endif
+    if (!m_file.isOpen()) {
+        return;
+    }
+    if (!m_binary) {
+        file += line;
+        return;
+    }
+    char header[RecordHeader];
+    qToLittleEndian<qint64>(msecs, header);
+    header[8] = static_cast<char>(type);
+    qToLittleEndian<quint16>(static_cast<quint16>(text.size()), header + 9);
+    file.append(header, RecordHeader).append(text);
+}
+
+void AsyncLogger::writeFile(const QByteArray &data)
+{
+    if (m_maxBytes > 0 && m_file.size() > 0 && m_file.size() + data.size() > m_maxBytes) {
+        rotate();
+    }
+    m_file.write(data);
+    m_file.flush();
+}
+
+bool AsyncLogger::openFile(const QString &path)
+{
+    m_file.close();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    // a binary file has to start with the magic and a text one can't have it,
+    // one left over in the other format gets rotated out of the way
+    QFile existing(path);
+    const bool reuse = !existing.open(QIODevice::ReadOnly) || existing.size() == 0 ||
+                       (existing.read(BinaryMagic.size()) == BinaryMagic) == m_binary;
+    existing.close();
+    m_file.setFileName(path);
+    if (!reuse) {
+        rotate();
+        return m_file.isOpen();
+    }
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        return false;
+    }
+    if (m_binary && m_file.size() == 0) {
+        m_file.write(BinaryMagic);
+    }
+    return true;
+}
+
+void AsyncLogger::rotate()
+{
+    const QString path = m_file.fileName();
+    m_file.close();
+    QFile::remove(u"%1.%2"_qs.arg(path).arg(KeepFiles));
+    for (int i = KeepFiles - 1; i > 0; i--) {
+        QFile::rename(u"%1.%2"_qs.arg(path).arg(i), u"%1.%2"_qs.arg(path).arg(i + 1));
+    }
+    QFile::rename(path, path + u".1"_qs);
+    if (m_file.open(QIODevice::WriteOnly | QIODevice::Append) && m_binary) {
+        m_file.write(BinaryMagic);
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef ASYNCLOGGER_H
+#define ASYNCLOGGER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QSemaphore>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+/* Qt message handler that never makes the logging thread wait on a terminal
+ * or a disk.
+ *
+ * Lines are stamped and copied into a fixed ring of slots that any thread can
+ * claim without taking a lock, and a writer thread drains it in batches, so
+ * one fwrite and one flush cover however many lines piled up since the last
+ * one. When the ring is full the line is dropped and counted rather than
+ * making the caller wait, the writer says how many it lost next time round.
+ *
+ * Lines go to stdout/stderr like messageHandler() and optionally to a log
+ * file that is rotated once it gets too big. The file can be plain text or a
+ * compact binary format, decode() turns that back into text:
+ *
+ *   "CHAPLOG1" then per line: qint64 msecs since epoch, quint8 QtMsgType,
+ *   quint16 length, that many bytes of utf-8, numbers little endian
+ *
+ * Install it once from main(), it is torn down when the process exits and
+ * hands back to messageHandler() for anything logged after that.
+ */
+class AsyncLogger
+{
+  public:
+    // slots in the ring, a power of two
+    inline const static quint64 Capacity = 2048;
+    // longer lines are cut short, it keeps the slots a fixed size
+    inline const static int MaxLine = 1000;
+    // how long the writer lets lines pile up before writing them out
+    inline const static int FlushInterval = 50;
+    // rotated files kept next to the log as <file>.1, <file>.2, ...
+    inline const static int KeepFiles = 3;
+    inline const static QByteArray BinaryMagic = QByteArrayLiteral("CHAPLOG1");
+    // msecs, type and length in front of every binary line
+    inline const static int RecordHeader = 11;
+
+    static void install();
+    // also write to path, rotating it past maxBytes, 0 or less never rotates
+    static bool logToFile(const QString &path, const qint64 &maxBytes, bool binary = false);
+    // lines thrown away because the ring was full
+    static quint64 dropped();
+    // text for a binary log, empty if it isn't one
+    static QByteArray decode(const QByteArray &binary);
+
+    static void handler(QtMsgType type, const QMessageLogContext &, const QString &msg);
+
+    ~AsyncLogger();
+
+  private:
+    struct Record {
+        qint64 msecs;
+        QtMsgType type;
+        quint16 length;
+        char text[MaxLine];
+    };
+    struct Slot {
+        // which lap of the ring this slot is ready for, see push() and drain()
+        std::atomic<quint64> sequence;
+        Record record;
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    // next slot a producer claims, only ever moves forward
+    std::atomic<quint64> m_head;
+    // next slot the writer reads, only touched under m_drainLock
+    quint64 m_tail;
+    std::atomic<quint64> m_dropped;
+    quint64 m_reportedDropped;
+    std::atomic<bool> m_stopping;
+    QSemaphore m_wake;
+    // held while draining, so a fatal message can flush from its own thread
+    QMutex m_drainLock;
+    QFile m_file;
+    qint64 m_maxBytes;
+    bool m_binary;
+    std::thread m_writer;
+
+    AsyncLogger();
+
+    bool push(const QtMsgType &type, const QString &msg);
+    void run();
+    void drain();
+    void write(const Record &record, QByteArray &out, QByteArray &err, QByteArray &file) const;
+    void append(const qint64 &msecs, const QtMsgType &type, const QByteArray &text, QByteArray &out,
+                QByteArray &err, QByteArray &file) const;
+    void writeFile(const QByteArray &data);
+    bool openFile(const QString &path);
+    void rotate();
+};
+
+#endif // ASYNCLOGGER_H
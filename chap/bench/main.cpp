@@ -0,0 +1,230 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+#include <cstdlib>
+#include <functional>
+#include <new>
+
+#include "../helixparser.h"
+#include "../qtutils.h"
+
+// allocations made through operator new on this thread while a measurement
+// is running, qt's containers allocate their data with malloc so those don't
+// show up here, other threads and setup work never do
+static thread_local bool countingAllocations = false;
+static thread_local quint64 allocations = 0;
+
+void *operator new(std::size_t size)
+{
+    if (countingAllocations) {
+        allocations++;
+    }
+    if (void *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+// shaped like a real helix reward, most of it is stuff we never read
+static QJsonObject reward(const int &i)
+{
+    const QJsonObject image{
+        {u"url_1x"_qs, u"https://static-cdn.jtvnw.net/custom-reward-images/default-1.png"_qs},
+        {u"url_2x"_qs, u"https://static-cdn.jtvnw.net/custom-reward-images/default-2.png"_qs},
+        {u"url_4x"_qs, u"https://static-cdn.jtvnw.net/custom-reward-images/default-4.png"_qs},
+    };
+    return {
+        {u"broadcaster_id"_qs, u"274637212"_qs},
+        {u"broadcaster_login"_qs, u"torpedo09"_qs},
+        {u"broadcaster_name"_qs, u"torpedo09"_qs},
+        {u"id"_qs, u"92af127c-7326-4483-a52b-b0da0be6%1"_qs.arg(i, 4, 10, QChar(u'0'))},
+        {u"title"_qs, u"Reward number %1"_qs.arg(i)},
+        {u"prompt"_qs, u"Redeem to do the thing ✨ with \"quotes\""_qs},
+        {u"cost"_qs, 100 + i},
+        {u"image"_qs, image},
+        {u"default_image"_qs, image},
+        {u"background_color"_qs, u"#00E5CB"_qs},
+        {u"is_enabled"_qs, true},
+        {u"is_user_input_required"_qs, false},
+        {u"max_per_stream_setting"_qs,
+         QJsonObject{{u"is_enabled"_qs, false}, {u"max_per_stream"_qs, 0}}},
+        {u"max_per_user_per_stream_setting"_qs,
+         QJsonObject{{u"is_enabled"_qs, false}, {u"max_per_user_per_stream"_qs, 0}}},
+        {u"global_cooldown_setting"_qs,
+         QJsonObject{{u"is_enabled"_qs, true}, {u"global_cooldown_seconds"_qs, 30}}},
+        {u"is_paused"_qs, false},
+        {u"is_in_stock"_qs, true},
+        {u"should_redemptions_skip_request_queue"_qs, false},
+        {u"redemptions_redeemed_current_stream"_qs, QJsonValue::Null},
+        {u"cooldown_expires_at"_qs, QJsonValue::Null},
+    };
+}
+
+// shaped like a real helix redemption
+static QJsonObject redemption(const int &i)
+{
+    return {
+        {u"broadcaster_id"_qs, u"274637212"_qs},
+        {u"broadcaster_login"_qs, u"torpedo09"_qs},
+        {u"broadcaster_name"_qs, u"torpedo09"_qs},
+        {u"id"_qs, u"17fa2df1-ad76-4804-bfa5-a40ef63e%1"_qs.arg(i, 4, 10, QChar(u'0'))},
+        {u"user_id"_qs, QString::number(274637212 + i)},
+        {u"user_login"_qs, u"viewer%1"_qs.arg(i)},
+        {u"user_name"_qs, u"Viewer%1"_qs.arg(i)},
+        {u"user_input"_qs, i % 4 == 0 ? u"please \\ do it\n"_qs : u""_qs},
+        {u"status"_qs, u"UNFULFILLED"_qs},
+        {u"redeemed_at"_qs, u"2020-07-01T18:37:32.123Z"_qs},
+        {u"reward"_qs, QJsonObject{{u"id"_qs, u"92af127c-7326-4483-a52b-b0da0be61c01"_qs},
+                                   {u"title"_qs, u"Shock The Streamer"_qs},
+                                   {u"prompt"_qs, u"Zap zap"_qs},
+                                   {u"cost"_qs, 100}}},
+    };
+}
+
+static QByteArray page(const std::function<QJsonObject(int)> &item, const int &count)
+{
+    QJsonArray data;
+    for (int i = 0; i < count; i++) {
+        data.append(item(i));
+    }
+    QJsonObject response{
+        {u"data"_qs, data},
+        {u"pagination"_qs, QJsonObject{{u"cursor"_qs, u"eyJiIjpudWxsLCJhIjp7IkN1cnNvciI6I"_qs}}},
+    };
+    return QJsonDocument(response).toJson(QJsonDocument::Compact);
+}
+
+struct Result {
+    double usecs;
+    double allocations;
+    qsizetype items;
+};
+
+static Result measure(const int &iterations, const std::function<qsizetype()> &parse)
+{
+    // one untimed run to get lazily initialized bits out of the way
+    qsizetype items = parse();
+    allocations = 0;
+    countingAllocations = true;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; i++) {
+        items = parse();
+    }
+    const qint64 nsecs = timer.nsecsElapsed();
+    countingAllocations = false;
+    return {nsecs / 1000.0 / iterations,
+            static_cast<double>(allocations) / iterations, items};
+}
+
+static void report(QTextStream &out, const QString &name, const QByteArray &payload,
+                   const int &iterations)
+{
+    const bool redemptions = payload.contains("\"redeemed_at\"");
+
+    // what twitchmanager used to do, a DOM and then a variant tree per item
+    const Result variant = measure(iterations, [&]() {
+        const QJsonObject response = QJsonDocument::fromJson(payload).object();
+        QList<QVariantMap> items;
+        for (auto value : response.value(u"data"_qs).toArray()) {
+            items.append(value.toObject().toVariantMap());
+        }
+        return items.size();
+    });
+    // a DOM but straight into the typed structs
+    const Result dom = measure(iterations, [&]() -> qsizetype {
+        const QJsonObject response = QJsonDocument::fromJson(payload).object();
+        const QJsonArray data = response.value(u"data"_qs).toArray();
+        if (redemptions) {
+            QList<Redemption> items;
+            for (auto value : data) {
+                items.append(Redemption::fromJson(value.toObject()));
+            }
+            return items.size();
+        }
+        QList<Reward> items;
+        for (auto value : data) {
+            items.append(Reward::fromJson(value.toObject()));
+        }
+        return items.size();
+    });
+    const Result parser = measure(iterations, [&]() -> qsizetype {
+        if (redemptions) {
+            QList<Redemption> items;
+            QString cursor;
+            HelixParser::parseRedemptions(payload, items, &cursor);
+            return items.size();
+        }
+        QList<Reward> items;
+        HelixParser::parseRewards(payload, items);
+        return items.size();
+    });
+
+    out << name << u": "_qs << payload.size() << u" bytes, "_qs << parser.items << u" items"_qs
+        << Qt::endl;
+    const auto row = [&](const QString &path, const Result &result) {
+        out << u"  "_qs << path.leftJustified(14) << QString::number(result.usecs, 'f', 1)
+            << u" us/parse"_qs;
+        out << u"  "_qs << QString::number(result.allocations, 'f', 0) << u" allocs/parse"_qs;
+        out << u"  x"_qs << QString::number(variant.usecs / result.usecs, 'f', 2) << Qt::endl;
+    };
+    row(u"variant map"_qs, variant);
+    row(u"json + typed"_qs, dom);
+    row(u"helix parser"_qs, parser);
+    if (parser.items != variant.items) {
+        out << u"  item counts differ! "_qs << parser.items << u" vs "_qs << variant.items
+            << Qt::endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    qInstallMessageHandler(messageHandler);
+
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(u"chap-bench"_qs);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        u"Compares parsing helix responses through QVariantMap against HelixParser."_qs);
+    parser.addHelpOption();
+    QCommandLineOption iterationsOption(u"iterations"_qs, u"Parse each payload <n> times."_qs,
+                                        u"n"_qs, u"500"_qs);
+    QCommandLineOption itemsOption(u"items"_qs, u"Items in each generated payload."_qs, u"n"_qs,
+                                   u"1000"_qs);
+    parser.addOptions({iterationsOption, itemsOption});
+    parser.addPositionalArgument(u"files"_qs, u"Recorded helix responses to parse."_qs,
+                                 u"[files...]"_qs);
+    parser.process(app);
+
+    const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+    const int items = qMax(1, parser.value(itemsOption).toInt());
+    QTextStream out(stdout);
+
+    const QStringList files = parser.positionalArguments();
+    if (files.isEmpty()) {
+        // a full page as helix sends it, and a flood bigger than any page
+        report(out, u"rewards x50"_qs, page(reward, 50), iterations);
+        report(out, u"redemptions x50"_qs, page(redemption, 50), iterations);
+        report(out, u"redemptions x%1"_qs.arg(items), page(redemption, items),
+               qMax(1, iterations / 10));
+    }
+    for (const QString &path : files) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qWarning() << "Failed to open:" << path;
+            return 1;
+        }
+        report(out, QFileInfo(path).fileName(), file.readAll(), iterations);
+    }
+    return 0;
+}
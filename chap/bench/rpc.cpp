@@ -0,0 +1,142 @@
+#include <QCborArray>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+
+#include "../qtutils.h"
+#include "../rpcclient.h"
+#include "../rpcserver.h"
+
+static QString percentiles(QList<qint64> micros)
+{
+    std::sort(micros.begin(), micros.end());
+    const auto at = [&micros](const double &p) {
+        const qsizetype index = static_cast<qsizetype>(p * (micros.size() - 1) + 0.5);
+        return micros[qMin(index, micros.size() - 1)];
+    };
+    return u"p50 %1  p99 %2  max %3 us"_qs.arg(at(0.5)).arg(at(0.99)).arg(micros.back());
+}
+
+int main(int argc, char *argv[])
+{
+    qInstallMessageHandler(messageHandler);
+
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(u"chap-rpc-bench"_qs);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        u"Measures round trips and pipelined throughput on the chap-rpc protocol."_qs);
+    parser.addHelpOption();
+    QCommandLineOption requestsOption(u"requests"_qs, u"Send <n> requests per pass."_qs, u"n"_qs,
+                                      u"20000"_qs);
+    QCommandLineOption windowOption(u"window"_qs, u"Keep up to <n> requests in flight."_qs,
+                                    u"n"_qs, u"64"_qs);
+    QCommandLineOption queryOption(u"query"_qs, u"Send Query instead of Ping."_qs);
+    QCommandLineOption serverOption(
+        u"server"_qs, u"Measure the running chap listening on <name> instead of our own server."_qs,
+        u"name"_qs);
+    parser.addOptions({requestsOption, windowOption, queryOption, serverOption});
+    parser.process(app);
+
+    const int requests = qMax(1, parser.value(requestsOption).toInt());
+    const int window = qMax(1, parser.value(windowOption).toInt());
+    const RpcFrame::Command command = parser.isSet(queryOption) ? RpcFrame::Query : RpcFrame::Ping;
+
+    // our own server gets a thread of its own like a real one would have,
+    // with a query answer about the size of a real one
+    QThread serverThread;
+    const auto stopServer = [&serverThread]() {
+        serverThread.quit();
+        serverThread.wait();
+    };
+    QString name = parser.value(serverOption);
+    if (name.isEmpty()) {
+        name = u"chap-rpc-bench-%1"_qs.arg(QCoreApplication::applicationPid());
+        RpcServer *server = new RpcServer();
+        server->handle(RpcFrame::Query, [](const QCborMap &, QCborMap &result) {
+            result = {
+                {u"channels"_qs, QCborArray{QString()}},
+                {u"loggedIn"_qs, true},
+                {u"eventSub"_qs, true},
+                {u"shock"_qs, QCborMap{{u"online"_qs, true}, {u"backlog"_qs, 0}}},
+                {u"smoke"_qs, QCborMap{{u"online"_qs, true}, {u"backlog"_qs, 0},
+                                       {u"duration"_qs, 5}}},
+            };
+            return RpcFrame::Ok;
+        });
+        server->moveToThread(&serverThread);
+        QObject::connect(&serverThread, &QThread::finished, server, &QObject::deleteLater);
+        serverThread.start();
+        bool listening = false;
+        QMetaObject::invokeMethod(
+            server, [server, name, &listening]() { listening = server->listen(name); },
+            Qt::BlockingQueuedConnection);
+        if (!listening) {
+            stopServer();
+            return 1;
+        }
+    }
+
+    RpcClient client;
+    if (!client.connectToServer(name)) {
+        qCritical() << "Nothing is listening on" << name;
+        stopServer();
+        return 1;
+    }
+    QTextStream out(stdout);
+
+    // one at a time, what a stream deck button press costs
+    QList<qint64> roundTrips;
+    roundTrips.reserve(requests);
+    for (int i = 0; i < requests; i++) {
+        const qint64 start = steadyMicros();
+        if (client.call(command) != RpcFrame::Ok) {
+            qCritical() << "Request" << i << "failed";
+            stopServer();
+            return 1;
+        }
+        roundTrips.append(steadyMicros() - start);
+    }
+    out << u"round trip   "_qs << percentiles(roundTrips) << Qt::endl;
+
+    // pipelined, how much a script can push through one connection
+    int sent = 0;
+    int answered = 0;
+    QEventLoop loop;
+    QObject::connect(&client, &RpcClient::replied, &loop,
+                     [&](const quint32 &, const RpcFrame::Status &status) {
+                         if (status != RpcFrame::Ok) {
+                             qCritical() << "Pipelined request failed";
+                             loop.exit(1);
+                             return;
+                         }
+                         if (++answered == requests) {
+                             loop.quit();
+                         } else if (sent < requests) {
+                             client.send(command);
+                             sent++;
+                         }
+                     });
+    QObject::connect(&client, &RpcClient::disconnected, &loop, [&loop]() { loop.exit(1); });
+    QTimer::singleShot(60 * 1000, &loop, [&loop]() { loop.exit(1); });
+    const qint64 start = steadyMicros();
+    for (; sent < qMin(window, requests); sent++) {
+        client.send(command);
+    }
+    const int failed = loop.exec();
+    const qint64 elapsed = steadyMicros() - start;
+    stopServer();
+    if (failed) {
+        qCritical() << "Only" << answered << "of" << requests << "pipelined requests answered";
+        return 1;
+    }
+    out << u"pipelined    "_qs << QString::number(requests * 1e6 / elapsed, 'f', 0)
+        << u" requests/s with "_qs << window << u" in flight"_qs << Qt::endl;
+    return 0;
+}
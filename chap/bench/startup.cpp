@@ -0,0 +1,119 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+
+#include "../qtutils.h"
+
+static double median(QList<double> values)
+{
+    std::sort(values.begin(), values.end());
+    const qsizetype middle = values.size() / 2;
+    return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+int main(int argc, char *argv[])
+{
+    qInstallMessageHandler(messageHandler);
+
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(u"chap-startup-bench"_qs);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        u"Starts chap offscreen a few times and fails if the first frame is over budget."_qs);
+    parser.addHelpOption();
+    QCommandLineOption runsOption(u"runs"_qs, u"Start chap <n> times."_qs, u"n"_qs, u"5"_qs);
+    QCommandLineOption budgetOption(u"budget"_qs,
+                                    u"Fail when the median first frame takes over <ms>."_qs,
+                                    u"ms"_qs, u"1500"_qs);
+    QCommandLineOption timeoutOption(u"timeout"_qs, u"Give up on a run after <ms>."_qs, u"ms"_qs,
+                                     u"30000"_qs);
+    parser.addOptions({runsOption, budgetOption, timeoutOption});
+    parser.addPositionalArgument(u"chap"_qs, u"Path to the chap binary."_qs, u"<chap>"_qs);
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(1);
+    }
+    const QString chap = parser.positionalArguments().constFirst();
+    const int runs = qMax(1, parser.value(runsOption).toInt());
+    const double budget = parser.value(budgetOption).toDouble();
+    const int timeout = qMax(1000, parser.value(timeoutOption).toInt());
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        qWarning() << "Failed to make a temporary directory:" << dir.errorString();
+        return 1;
+    }
+
+    // chap gets a home of its own so it starts like a fresh install, without
+    // the settings, session or journal of whoever runs us, and without
+    // finding the socket of a chap they have open and handing off to it
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    for (const QString &name : {u"HOME"_qs, u"XDG_CONFIG_HOME"_qs, u"XDG_DATA_HOME"_qs,
+                                u"XDG_CACHE_HOME"_qs, u"XDG_STATE_HOME"_qs, u"XDG_RUNTIME_DIR"_qs,
+                                u"APPDATA"_qs, u"LOCALAPPDATA"_qs, u"TMPDIR"_qs}) {
+        const QString path = dir.filePath(name.toLower());
+        if (!QDir().mkpath(path)) {
+            qWarning() << "Failed to make" << path;
+            return 1;
+        }
+        environment.insert(name, path);
+    }
+
+    // phase name to when it ended in each run
+    QMap<QString, QList<double>> ends;
+    for (int run = 0; run < runs; run++) {
+        const QString report = dir.filePath(u"startup-%1.json"_qs.arg(run));
+        QProcess process;
+        process.setProcessEnvironment(environment);
+        process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        process.start(chap, {u"-platform"_qs, u"offscreen"_qs, u"--startup-report"_qs, report});
+        if (!process.waitForFinished(timeout)) {
+            qWarning() << "Run" << run << "didn't finish in" << timeout << "ms";
+            process.kill();
+            process.waitForFinished();
+            return 1;
+        }
+        QFile file(report);
+        if (process.exitCode() != 0 || !file.open(QIODevice::ReadOnly)) {
+            qWarning() << "Run" << run << "exited with" << process.exitCode()
+                       << "or left no report";
+            return 1;
+        }
+        const QJsonObject phases = QJsonDocument::fromJson(file.readAll()).object();
+        for (auto it = phases.constBegin(); it != phases.constEnd(); ++it) {
+            ends[it.key()].append(it->toObject().value(u"end"_qs).toDouble());
+        }
+    }
+
+    QTextStream out(stdout);
+    out << u"Median msecs from launch over "_qs << runs << u" runs:"_qs << Qt::endl;
+    for (auto it = ends.constBegin(); it != ends.constEnd(); ++it) {
+        out << u"  "_qs << it.key().leftJustified(20) << QString::number(median(*it), 'f', 1)
+            << Qt::endl;
+    }
+
+    const QList<double> frames = ends.value(u"firstFrame"_qs);
+    if (frames.size() != runs) {
+        qWarning() << "Not every run reported a first frame";
+        return 1;
+    }
+    const double firstFrame = median(frames);
+    if (firstFrame > budget) {
+        out << u"First frame took "_qs << QString::number(firstFrame, 'f', 1)
+            << u" ms, over the "_qs << budget << u" ms budget"_qs << Qt::endl;
+        return 1;
+    }
+    out << u"First frame within the "_qs << budget << u" ms budget"_qs << Qt::endl;
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include "channel.h"
+
+Channel::Channel(const QString &name, QNetworkAccessManager *nam, HelixScheduler *scheduler,
+                 RedemptionRouter::QueueLookup queues, QObject *parent)
+    : QObject{parent}
+    , m_name(name)
+    , m_twitchManager(new TwitchManager(scheduler, name, this))
+    , m_shockCollarManager(new ShockCollarManager(nam, this))
+    , m_smokeMachineManager(new SmokeMachineManager(nam, this))
+    , m_router(new RedemptionRouter(m_twitchManager, m_shockCollarManager, m_smokeMachineManager,
+                                    std::move(queues), this))
+    , m_latency(new LatencyTracker(m_twitchManager, m_shockCollarManager, m_smokeMachineManager,
+                                   this))
+{
+    // the journal follows redemptions through the devices, so a crash at any
+    // point leaves a record of how far each one got
+    RedemptionJournal *journal = m_twitchManager->journal();
+    connect(m_shockCollarManager, &ShockCollarManager::dispatched, journal,
+            &RedemptionJournal::dispatched);
+    connect(m_shockCollarManager, &ShockCollarManager::acked, journal, &RedemptionJournal::acked);
+    connect(m_smokeMachineManager, &SmokeMachineManager::dispatched, journal,
+            &RedemptionJournal::dispatched);
+    connect(m_smokeMachineManager, &SmokeMachineManager::acked, journal,
+            &RedemptionJournal::acked);
+}
+
+void Channel::sharedDispatched(const RedemptionRouter::Action &action,
+                               const QList<QString> &redemptionIds)
+{
+    m_twitchManager->journal()->dispatched(redemptionIds);
+    m_latency->dispatched(action == RedemptionRouter::Smoke ? LatencyTracker::SmokeMachine
+                                                            : LatencyTracker::ShockCollar,
+                          redemptionIds);
+}
+
+void Channel::sharedAcked(const QList<QString> &redemptionIds, bool success)
+{
+    m_twitchManager->journal()->acked(redemptionIds, success);
+    m_latency->deviceAcked(redemptionIds, success);
+    m_router->deviceAcked(redemptionIds, success);
+}
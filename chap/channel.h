@@ -0,0 +1,64 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <QObject>
+
+#include "latencytracker.h"
+#include "qmlsupport.h"
+#include "redemptionrouter.h"
+#include "shockcollarmanager.h"
+#include "smokemachinemanager.h"
+#include "twitchmanager.h"
+
+/* Everything that belongs to one broadcaster.
+ *
+ * A channel has its own session and token lifecycle, reward list, journal
+ * and eventsub connection, plus the devices its redemptions go to and the
+ * router between them. The network stack and helix scheduler are shared with
+ * every other channel in the process, the scheduler still keeps a rate limit
+ * bucket per channel since twitch counts each token separately. So are the
+ * device queues, per address, since two channels can point at one device.
+ *
+ * The default channel has an empty name and keeps its files where a single
+ * channel always has, so existing setups carry on as they were.
+ */
+class Channel : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Backend only.")
+
+  public:
+    explicit Channel(const QString &name, QNetworkAccessManager *nam, HelixScheduler *scheduler,
+                     RedemptionRouter::QueueLookup queues, QObject *parent = nullptr);
+
+    const QString &name() const { return m_name; }
+    TwitchManager *twitch() const { return m_twitchManager; }
+    ShockCollarManager *shockCollar() const { return m_shockCollarManager; }
+    SmokeMachineManager *smokeMachine() const { return m_smokeMachineManager; }
+    RedemptionRouter *router() const { return m_router; }
+    LatencyTracker *latency() const { return m_latency; }
+
+    // runs that went out through another channel's device at an address we
+    // share, whatever of them is ours gets journaled, timed and settled
+    void sharedDispatched(const RedemptionRouter::Action &action,
+                          const QList<QString> &redemptionIds);
+    void sharedAcked(const QList<QString> &redemptionIds, bool success);
+
+  private:
+    Q_PROPERTY(QString name READ name CONSTANT)
+    Q_PROPERTY(TwitchManager *twitch READ twitch CONSTANT)
+    Q_PROPERTY(ShockCollarManager *shockCollar READ shockCollar CONSTANT)
+    Q_PROPERTY(SmokeMachineManager *smokeMachine READ smokeMachine CONSTANT)
+    Q_PROPERTY(RedemptionRouter *router READ router CONSTANT)
+    Q_PROPERTY(LatencyTracker *latency READ latency CONSTANT)
+
+    QString m_name;
+    TwitchManager *m_twitchManager;
+    ShockCollarManager *m_shockCollarManager;
+    SmokeMachineManager *m_smokeMachineManager;
+    RedemptionRouter *m_router;
+    LatencyTracker *m_latency;
+};
+
+#endif // CHANNEL_H
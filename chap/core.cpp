@@ -1,21 +1,35 @@
 #include "core.h"
 
+#include <QCborArray>
+#include <QRegularExpression>
+#include <QSettings>
+#include <QTimer>
+
+#include <algorithm>
+#include <memory>
+#ifndef CHAP_HEADLESS
 #include <QDesktopServices>
 #include <QFileOpenEvent>
-#include <QSettings>
+#endif
 
 #define URL_SCHEME u"chap"_qs
 
 Core::Core(QObject *parent)
     : QObject{parent}
-    , m_localServer(new QLocalServer(this))
-    , m_twitchManager(new TwitchManager(this))
-    , m_shockCollarManager(new ShockCollarManager(this))
-    , m_smokeMachineManager(new SmokeMachineManager(this))
+    , m_startup(new StartupPipeline(this))
+    , m_rpc(new RpcServer(this))
+    , m_nam(new QNetworkAccessManager(this))
+    , m_scheduler(new HelixScheduler(m_nam, this))
+    , m_shockQueues()
+    , m_smokeQueues()
+    , m_channels({new Channel({}, m_nam, m_scheduler, queueLookup(), this)})
 {
-    // setup handler so we can get route callbacks
+    // setup handler so we can get route callbacks, headless we only get them
+    // forwarded from another instance over the local server
+#ifndef CHAP_HEADLESS
     parent->installEventFilter(this);
     QDesktopServices::setUrlHandler(URL_SCHEME, this, "handleCallback");
+#endif
 #ifdef Q_OS_WIN
     // on windows we add/update the registry to ensure we get callbacks
     const QString appPath = QDir::toNativeSeparators(qApp->applicationFilePath());
@@ -33,27 +47,307 @@ Core::Core(QObject *parent)
     qDebug() << "Registerd handler:" << execCmd;
 #endif
 
-    // setup local server for ipc (only used on Windows atm)
-    m_localServer->listen(u"chap-rpc"_qs);
-    connect(m_localServer, &QLocalServer::newConnection, this, &Core::newLocalConnection);
+    // everyone else we serve, the default channel's devices are left to
+    // whoever runs us like they always were
+    shareDevices(m_channels.first());
+    addStartupSteps(m_channels.first());
+    loadChannels();
+
+    // callbacks forwarded from another instance, and anything scripting us
+    addRpcHandlers();
+    m_rpc->listen();
+
+    // whoever made us gets until the event loop starts to add their own steps
+    QTimer::singleShot(0, m_startup, &StartupPipeline::start);
 }
 
 Core::~Core()
 {
+    // channels go before the scheduler and network stack they share
+    qDeleteAll(m_channels);
+    m_channels.clear();
+#ifndef CHAP_HEADLESS
     QDesktopServices::unsetUrlHandler(URL_SCHEME);
+#endif
 #ifdef Q_OS_WIN
     QSettings reg(u"HKEY_CURRENT_USER\\Software\\Classes"_qs, QSettings::NativeFormat);
     reg.remove(URL_SCHEME);
 #endif
 }
 
-void Core::save() {}
+Channel *Core::channel(const QString &name) const
+{
+    for (Channel *channel : m_channels) {
+        if (channel->name() == name) {
+            return channel;
+        }
+    }
+    return nullptr;
+}
+
+ActionQueue *Core::deviceQueue(const RedemptionRouter::Action &action, const QString &address)
+{
+    const bool smoke = action == RedemptionRouter::Smoke;
+    QHash<QString, ActionQueue *> &queues = smoke ? m_smokeQueues : m_shockQueues;
+    if (ActionQueue *existing = queues.value(address)) {
+        return existing;
+    }
+    ActionQueue *queue = new ActionQueue(
+        (smoke ? u"smoke machine %1"_qs : u"shock collar %1"_qs).arg(address),
+        [this, action, address](const QList<QString> &ids, int duration) {
+            runDevice(action, address, ids, duration);
+        },
+        this);
+    // one shock per redemption, smoke piles up into one longer run
+    if (smoke) {
+        queue->setPolicy(ActionQueue::ExtendDuration);
+        queue->setMinGap(RedemptionRouter::SmokeGap);
+        queue->setMaxDuration(RedemptionRouter::MaxSmokeDuration);
+    } else {
+        queue->setPolicy(ActionQueue::Sequential);
+        queue->setMinGap(RedemptionRouter::ShockGap);
+    }
+    // every router settles the ones that are its own
+    connect(queue, &ActionQueue::dropped, this, [this](const QList<QString> &ids) {
+        for (Channel *channel : qAsConst(m_channels)) {
+            channel->router()->drop(ids);
+        }
+    });
+    queues.insert(address, queue);
+    return queue;
+}
+
+RedemptionRouter::QueueLookup Core::queueLookup()
+{
+    return [this](RedemptionRouter::Action action, const QString &address) {
+        return deviceQueue(action, address);
+    };
+}
+
+void Core::runDevice(const RedemptionRouter::Action &action, const QString &address,
+                     const QList<QString> &redemptionIds, const int &duration)
+{
+    // a run can hold redemptions from several channels, but the device only
+    // gets one request for it, the collar would go off once per request, so
+    // it goes out through one channel and shareDevices() tells the rest, one
+    // at the address that queued part of the run is best, then any at the
+    // address, then one that queued part of it and has since moved on
+    Channel *firing = nullptr;
+    int best = 0;
+    for (Channel *channel : qAsConst(m_channels)) {
+        const QString current = action == RedemptionRouter::Smoke
+                                    ? channel->smokeMachine()->ipAddress()
+                                    : channel->shockCollar()->ipAddress();
+        const bool queuedHere =
+            std::any_of(redemptionIds.cbegin(), redemptionIds.cend(),
+                        [channel](const QString &id) { return channel->router()->queued(id); });
+        const int score = (current == address ? 2 : 0) + (queuedHere ? 1 : 0);
+        if (score > best) {
+            best = score;
+            firing = channel;
+        }
+    }
+    if (!firing) {
+        qWarning() << "No channel left at" << address << "to run its queue";
+        return;
+    }
+    firing->router()->run(action, redemptionIds, duration);
+}
+
+void Core::shareDevices(Channel *channel)
+{
+    // every other channel hears how our runs went and picks out its own,
+    // the ones that don't share the device just find nothing of theirs
+    const auto others = [this, channel]() {
+        QList<Channel *> others = m_channels;
+        others.removeOne(channel);
+        return others;
+    };
+    connect(channel->shockCollar(), &ShockCollarManager::dispatched, this,
+            [others](const QList<QString> &ids) {
+                for (Channel *other : others()) {
+                    other->sharedDispatched(RedemptionRouter::Shock, ids);
+                }
+            });
+    connect(channel->smokeMachine(), &SmokeMachineManager::dispatched, this,
+            [others](const QList<QString> &ids) {
+                for (Channel *other : others()) {
+                    other->sharedDispatched(RedemptionRouter::Smoke, ids);
+                }
+            });
+    const auto acked = [others](const QList<QString> &ids, bool success) {
+        for (Channel *other : others()) {
+            other->sharedAcked(ids, success);
+        }
+    };
+    connect(channel->shockCollar(), &ShockCollarManager::acked, this, acked);
+    connect(channel->smokeMachine(), &SmokeMachineManager::acked, this, acked);
+}
+
+void Core::loadChannels()
+{
+    QSettings settings;
+    settings.beginGroup(u"Channels"_qs);
+    for (const QString &name : settings.childGroups()) {
+        Channel *added = addChannel(name);
+        if (!added) {
+            continue;
+        }
+        settings.beginGroup(name);
+        if (settings.contains(u"Collar"_qs)) {
+            added->shockCollar()->setIpAddress(settings.value(u"Collar"_qs).toString());
+        }
+        if (settings.contains(u"SmokeMachine"_qs)) {
+            added->smokeMachine()->setIpAddress(settings.value(u"SmokeMachine"_qs).toString());
+        }
+        if (settings.contains(u"SmokeDuration"_qs)) {
+            added->smokeMachine()->setDuration(
+                qBound(1, settings.value(u"SmokeDuration"_qs).toInt(), 90));
+        }
+        settings.endGroup();
+    }
+    settings.endGroup();
+}
+
+Channel *Core::addChannel(const QString &name)
+{
+    static const QRegularExpression validName(u"^[A-Za-z0-9_]{1,25}$"_qs);
+    if (!validName.match(name).hasMatch()) {
+        qWarning() << "Not a valid channel name:" << name;
+        return nullptr;
+    }
+    if (Channel *existing = channel(name)) {
+        return existing;
+    }
+    qInfo() << "Adding channel:" << name;
+    Channel *added = new Channel(name, m_nam, m_scheduler, queueLookup(), this);
+    m_channels.append(added);
+    shareDevices(added);
+    addStartupSteps(added);
+    emit channelAdded(added);
+    emit channelsChanged();
+    return added;
+}
+
+void Core::addStartupSteps(Channel *channel)
+{
+    // the only real dependencies are on having a token and knowing the
+    // rewards, validating, probing the devices, and connecting eventsub all
+    // happen at once, and nothing here waits on the ui
+    const QString suffix = channel->name().isEmpty() ? QString() : u'@' + channel->name();
+    TwitchManager *twitch = channel->twitch();
+    using Done = StartupPipeline::Done;
+
+    // restored from disk along with the channel, though without one we have
+    // to wait on someone logging in
+    m_startup->add(u"session"_qs + suffix, {}, [twitch](Done done) {
+        if (twitch->loggedIn()) {
+            done();
+            return;
+        }
+        connect(twitch, &TwitchManager::loggedInChanged, twitch, [done](bool loggedIn) {
+            if (loggedIn) {
+                done();
+            }
+        });
+    });
+    // required at startup, but a restored token is good to use meanwhile,
+    // anything it gets refused for is replayed after a refresh, a failed
+    // validate still finishes the step so nothing waits on it forever
+    m_startup->add(u"validate"_qs + suffix, {}, [this, twitch, suffix](Done done) {
+        connect(twitch, &TwitchManager::validated, twitch, done, Qt::SingleShotConnection);
+        connect(
+            twitch, &TwitchManager::validateFailed, twitch,
+            [done, suffix]() {
+                qWarning().noquote() << u"Startup validate%1 failed, carrying on"_qs.arg(suffix);
+                done();
+            },
+            Qt::SingleShotConnection);
+        twitch->validate();
+        m_scheduler->flush();
+    });
+    // cached rewards are enough to route on, the fetch only catches us up,
+    // and one that fails leaves us with whatever we have rather than waiting
+    m_startup->add(
+        u"rewards"_qs + suffix, {u"session"_qs + suffix}, [this, twitch, suffix](Done done) {
+            if (twitch->rewards()->rowCount() > 0) {
+                done();
+            }
+            connect(twitch, &TwitchManager::gotRewards, twitch, done, Qt::SingleShotConnection);
+            connect(
+                twitch, &TwitchManager::rewardsFailed, twitch,
+                [done, suffix]() {
+                    qWarning().noquote()
+                        << u"Startup rewards%1 failed, carrying on"_qs.arg(suffix);
+                    done();
+                },
+                Qt::SingleShotConnection);
+            twitch->getRewards();
+            m_scheduler->flush();
+        });
+    // a stand-in may have connected before we got here, and a session that
+    // failed to validate has nothing to subscribe with so there's no waiting
+    m_startup->add(
+        u"eventsub"_qs + suffix, {u"session"_qs + suffix}, [this, twitch, suffix](Done done) {
+            const bool refused = m_startup->isDone(u"validate"_qs + suffix) &&
+                                 !twitch->validatedAt().isValid();
+            if (twitch->eventSub()->connected() || refused) {
+                done();
+                return;
+            }
+            connect(twitch->eventSub(), &EventSubClient::welcomed, twitch, done,
+                    Qt::SingleShotConnection);
+            connect(twitch, &TwitchManager::validateFailed, twitch, done,
+                    Qt::SingleShotConnection);
+            twitch->eventSub()->open();
+        });
+    // answered either way, a device that's down is still known to be down
+    m_startup->add(u"devices"_qs + suffix, {}, [channel](Done done) {
+        auto remaining = std::make_shared<int>(2);
+        auto pinged = [remaining, done]() {
+            if (--*remaining == 0) {
+                done();
+            }
+        };
+        connect(channel->shockCollar(), &ShockCollarManager::pinged, channel, pinged,
+                Qt::SingleShotConnection);
+        connect(channel->smokeMachine(), &SmokeMachineManager::pinged, channel, pinged,
+                Qt::SingleShotConnection);
+        channel->shockCollar()->ping();
+        channel->smokeMachine()->ping();
+    });
+    // dispatching before validate and eventsub are settled means redemptions
+    // we can't fulfill or don't hear about, every step it waits on but the
+    // session finishes even when it fails
+    m_startup->add(u"ready"_qs + suffix,
+                   {u"session"_qs + suffix, u"validate"_qs + suffix, u"rewards"_qs + suffix,
+                    u"eventsub"_qs + suffix, u"devices"_qs + suffix},
+                   [this, suffix](Done done) {
+                       done();
+                       qInfo().noquote() << u"Ready to dispatch%1 at %2 ms"_qs.arg(suffix).arg(
+                           m_startup->finishedAt(u"ready"_qs + suffix));
+                   });
+}
+
+void Core::save()
+{
+    for (Channel *channel : qAsConst(m_channels)) {
+        channel->twitch()->save();
+    }
+}
 
 void Core::handleCallback(const QUrl &url)
 {
     const QString host(url.host());
     if (host == u"twitch"_qs) {
-        m_twitchManager->handleCallback(url);
+        // only the channel that started the login knows the state
+        for (Channel *channel : qAsConst(m_channels)) {
+            if (channel->twitch()->expectsCallback(url)) {
+                channel->twitch()->handleCallback(url);
+                return;
+            }
+        }
+        twitch()->handleCallback(url);
         return;
     }
     qWarning() << "Failed to handle url:" << url;
@@ -61,34 +355,78 @@ void Core::handleCallback(const QUrl &url)
 
 bool Core::eventFilter(QObject *, QEvent *event)
 {
+#ifndef CHAP_HEADLESS
     if (event->type() == QEvent::FileOpen) {
         QFileOpenEvent *fileEvent = static_cast<QFileOpenEvent *>(event);
         handleCallback(fileEvent->url());
         return true;
     }
+#else
+    Q_UNUSED(event)
+#endif
     return false;
 }
 
-void Core::newLocalConnection()
+void Core::addRpcHandlers()
 {
-    QLocalSocket *conn = m_localServer->nextPendingConnection();
-    connect(conn, &QLocalSocket::disconnected, conn, &QLocalSocket::deleteLater);
-    connect(conn, &QLocalSocket::readyRead, this, &Core::localConnectionReadyRead);
-}
+    // every command but callback takes an optional channel, the default if left out
+    const auto target = [this](const QCborMap &args) {
+        return channel(args.value(u"channel"_qs).toString());
+    };
 
-void Core::localConnectionReadyRead()
-{
-    QLocalSocket *conn = qobject_cast<QLocalSocket *>(QObject::sender());
-    QDataStream stream(conn);
-    int argc;
-    stream >> argc;
-    for (int i = 0; i < argc; i++) {
-        char *b;
-        uint l;
-        stream.readBytes(b, l);
-        QString s(b);
-        if (s.startsWith(URL_SCHEME)) {
-            handleCallback(s);
+    m_rpc->handle(RpcFrame::Callback, [this](const QCborMap &args, QCborMap &) {
+        const QUrl url(args.value(u"url"_qs).toString());
+        if (url.scheme() != URL_SCHEME) {
+            return RpcFrame::BadRequest;
         }
-    }
+        handleCallback(url);
+        return RpcFrame::Ok;
+    });
+    m_rpc->handle(RpcFrame::Query, [this, target](const QCborMap &args, QCborMap &result) {
+        const Channel *found = target(args);
+        if (!found) {
+            return RpcFrame::UnknownChannel;
+        }
+        QCborArray names;
+        for (const Channel *channel : qAsConst(m_channels)) {
+            names.append(channel->name());
+        }
+        const RedemptionRouter *router = found->router();
+        result = {
+            {u"channels"_qs, names},
+            {u"loggedIn"_qs, found->twitch()->loggedIn()},
+            {u"eventSub"_qs, found->twitch()->eventSub()->connected()},
+            {u"shock"_qs, QCborMap{{u"online"_qs, found->shockCollar()->online()},
+                                   {u"backlog"_qs, router->shockQueue()->depth()}}},
+            {u"smoke"_qs, QCborMap{{u"online"_qs, found->smokeMachine()->online()},
+                                   {u"backlog"_qs, router->smokeQueue()->depth()},
+                                   {u"duration"_qs, found->smokeMachine()->duration()}}},
+        };
+        return RpcFrame::Ok;
+    });
+    // through the same queues as redemptions, so the gaps between runs hold
+    m_rpc->handle(RpcFrame::Shock, [target](const QCborMap &args, QCborMap &result) {
+        const Channel *found = target(args);
+        if (!found) {
+            return RpcFrame::UnknownChannel;
+        }
+        ActionQueue *queue = found->router()->shockQueue();
+        const bool queued = queue->enqueue({});
+        result.insert(u"backlog"_qs, queue->depth());
+        return queued ? RpcFrame::Ok : RpcFrame::Failed;
+    });
+    m_rpc->handle(RpcFrame::Smoke, [target](const QCborMap &args, QCborMap &result) {
+        const Channel *found = target(args);
+        if (!found) {
+            return RpcFrame::UnknownChannel;
+        }
+        const qint64 duration = args.value(u"duration"_qs).toInteger();
+        if (duration < 0 || duration > RedemptionRouter::MaxSmokeDuration) {
+            return RpcFrame::BadRequest;
+        }
+        ActionQueue *queue = found->router()->smokeQueue();
+        const bool queued = queue->enqueue({}, static_cast<int>(duration));
+        result.insert(u"backlog"_qs, queue->depth());
+        return queued ? RpcFrame::Ok : RpcFrame::Failed;
+    });
 }
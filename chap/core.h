@@ -1,13 +1,12 @@
 #ifndef CORE_H
 #define CORE_H
 
-#include <QLocalServer>
 #include <QObject>
-#include <QtQml>
 
-#include "shockcollarmanager.h"
-#include "smokemachinemanager.h"
-#include "twitchmanager.h"
+#include "channel.h"
+#include "qmlsupport.h"
+#include "rpcserver.h"
+#include "startuppipeline.h"
 
 class Core : public QObject
 {
@@ -20,23 +19,54 @@ class Core : public QObject
     ~Core();
     bool eventFilter(QObject *object, QEvent *event) override;
 
-    TwitchManager *twitch() const { return m_twitchManager; }
-    ShockCollarManager *shockCollar() const { return m_shockCollarManager; }
-    SmokeMachineManager *smokeMachine() const { return m_smokeMachineManager; }
+    // the default channel's, which is all there is unless more are added
+    TwitchManager *twitch() const { return m_channels.first()->twitch(); }
+    ShockCollarManager *shockCollar() const { return m_channels.first()->shockCollar(); }
+    SmokeMachineManager *smokeMachine() const { return m_channels.first()->smokeMachine(); }
+    RedemptionRouter *router() const { return m_channels.first()->router(); }
+    LatencyTracker *latency() const { return m_channels.first()->latency(); }
+
+    StartupPipeline *startup() const { return m_startup; }
+    HelixScheduler *scheduler() const { return m_scheduler; }
+    QList<Channel *> channels() const { return m_channels; }
+    Q_INVOKABLE Channel *channel(const QString &name = {}) const;
+    // one per device, however many channels point at it
+    ActionQueue *deviceQueue(const RedemptionRouter::Action &action, const QString &address);
+
+  signals:
+    void channelAdded(Channel *channel);
+    void channelsChanged();
 
   public slots:
     void save();
+    // channel names end up in paths, so they are held to twitch login rules
+    Channel *addChannel(const QString &name);
 
   private slots:
     void handleCallback(const QUrl &url);
-    void newLocalConnection();
-    void localConnectionReadyRead();
 
   private:
-    QLocalServer *m_localServer;
-    TwitchManager *m_twitchManager;
-    ShockCollarManager *m_shockCollarManager;
-    SmokeMachineManager *m_smokeMachineManager;
+    Q_PROPERTY(QList<Channel *> channels READ channels NOTIFY channelsChanged)
+    Q_PROPERTY(StartupPipeline *startup READ startup CONSTANT)
+
+    // first so its clock starts with us
+    StartupPipeline *m_startup;
+    RpcServer *m_rpc;
+    QNetworkAccessManager *m_nam;
+    HelixScheduler *m_scheduler;
+    // by device address, before the channels that look them up
+    QHash<QString, ActionQueue *> m_shockQueues;
+    QHash<QString, ActionQueue *> m_smokeQueues;
+    // the default channel is always first, channels live as long as we do
+    QList<Channel *> m_channels;
+
+    void loadChannels();
+    RedemptionRouter::QueueLookup queueLookup();
+    void runDevice(const RedemptionRouter::Action &action, const QString &address,
+                   const QList<QString> &redemptionIds, const int &duration);
+    void shareDevices(Channel *channel);
+    void addStartupSteps(Channel *channel);
+    void addRpcHandlers();
 };
 
 #endif // CORE_H
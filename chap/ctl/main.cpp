@@ -0,0 +1,81 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QHash>
+#include <QJsonDocument>
+#include <QTextStream>
+
+#include "../qtutils.h"
+#include "../rpcclient.h"
+
+int main(int argc, char *argv[])
+{
+    qInstallMessageHandler(messageHandler);
+
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(u"chapctl"_qs);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        u"Sends a command to a running chap or chapd, for scripts and stream deck buttons."_qs);
+    parser.addHelpOption();
+    QCommandLineOption channelOption(u"channel"_qs, u"Command channel <name>, not the default."_qs,
+                                     u"name"_qs);
+    QCommandLineOption durationOption(u"duration"_qs,
+                                      u"Run the smoke machine for <seconds>, not its default."_qs,
+                                      u"seconds"_qs, u"0"_qs);
+    QCommandLineOption serverOption(u"server"_qs, u"Talk to the socket called <name>."_qs,
+                                    u"name"_qs, RpcFrame::SocketName);
+    QCommandLineOption timeoutOption(u"timeout"_qs, u"Wait up to <ms> for an answer."_qs, u"ms"_qs,
+                                     u"1000"_qs);
+    parser.addOptions({channelOption, durationOption, serverOption, timeoutOption});
+    parser.addPositionalArgument(u"command"_qs,
+                                 u"ping, status, shock, smoke, hammer or callback <url>."_qs,
+                                 u"<command> [url]"_qs);
+    parser.process(app);
+
+    static const QHash<QString, RpcFrame::Command> commands{
+        {u"ping"_qs, RpcFrame::Ping},
+        {u"status"_qs, RpcFrame::Query},
+        {u"shock"_qs, RpcFrame::Shock},
+        {u"smoke"_qs, RpcFrame::Smoke},
+        {u"hammer"_qs, RpcFrame::Hammer},
+        {u"callback"_qs, RpcFrame::Callback},
+    };
+    const QStringList positional = parser.positionalArguments();
+    if (positional.isEmpty() || !commands.contains(positional.first())) {
+        parser.showHelp(1);
+    }
+    const RpcFrame::Command command = commands.value(positional.first());
+
+    QCborMap args;
+    if (parser.isSet(channelOption)) {
+        args.insert(u"channel"_qs, parser.value(channelOption));
+    }
+    if (command == RpcFrame::Smoke) {
+        args.insert(u"duration"_qs, parser.value(durationOption).toInt());
+    }
+    if (command == RpcFrame::Callback) {
+        if (positional.size() < 2) {
+            parser.showHelp(1);
+        }
+        args.insert(u"url"_qs, positional.at(1));
+    }
+
+    RpcClient client;
+    if (!client.connectToServer(parser.value(serverOption))) {
+        qCritical() << "Nothing is listening on" << parser.value(serverOption);
+        return 1;
+    }
+    QCborMap result;
+    const RpcFrame::Status status =
+        client.call(command, args, &result, parser.value(timeoutOption).toInt());
+    QTextStream out(stdout);
+    if (!result.isEmpty()) {
+        out << QJsonDocument(result.toJsonObject()).toJson();
+    }
+    if (status != RpcFrame::Ok) {
+        qCritical().noquote() << RpcFrame::statusName(status);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "daemon.h"
+
+Daemon::Daemon(Channel *channel, QObject *parent)
+    : QObject{parent}
+    , m_channel(channel)
+    , m_pollTimer(new QTimer(this))
+    , m_hadAllRewards(false)
+    , m_creating()
+{
+    TwitchManager *twitch = m_channel->twitch();
+    // nobody around to click login, print the url instead of waiting
+    twitch->setAutoLogin(true);
+
+    connect(twitch, &TwitchManager::validated, twitch, &TwitchManager::getRewards);
+    connect(twitch, &TwitchManager::gotRewards, this, &Daemon::gotRewards);
+    connect(twitch, &TwitchManager::shockRewardChanged, this, &Daemon::rewardsChanged);
+    connect(twitch, &TwitchManager::smokeRewardChanged, this, &Daemon::rewardsChanged);
+    connect(m_channel->shockCollar(), &ShockCollarManager::onlineChanged, this,
+            &Daemon::matchDevices);
+    connect(m_channel->smokeMachine(), &SmokeMachineManager::onlineChanged, this,
+            &Daemon::matchDevices);
+
+    // eventsub pushes redemptions to us, so only poll as a fallback
+    connect(twitch->eventSub(), &EventSubClient::connectedChanged, this,
+            &Daemon::updatePollInterval);
+    connect(m_pollTimer, &QTimer::timeout, this, &Daemon::getRedemptions);
+    updatePollInterval();
+    m_pollTimer->start();
+
+    // cached rewards are there before we even start, don't wait on the timer
+    // to catch up on anything redeemed while we were down
+    QTimer::singleShot(0, this, &Daemon::rewardsChanged);
+}
+
+void Daemon::getRedemptions()
+{
+    TwitchManager *twitch = m_channel->twitch();
+    if (!twitch->loggedIn()) {
+        return;
+    }
+    if (hasAllRewards()) {
+        twitch->syncRedemptions(twitch->shockReward().value<Reward>().id);
+        twitch->syncRedemptions(twitch->smokeReward().value<Reward>().id);
+    } else if (twitch->rewards()->rowCount() == 0) {
+        twitch->getRewards();
+    }
+}
+
+void Daemon::gotRewards()
+{
+    // this is the channel's actual reward list, anything missing from it
+    // really doesn't exist yet
+    TwitchManager *twitch = m_channel->twitch();
+    if (!twitch->shockReward().isValid()) {
+        createReward(TwitchManager::ShockRewardTitle, ShockCost, ShockCooldown);
+    }
+    if (!twitch->smokeReward().isValid()) {
+        createReward(TwitchManager::SmokeRewardTitle, SmokeCost, SmokeCooldown);
+    }
+    getRedemptions();
+}
+
+void Daemon::rewardsChanged()
+{
+    const bool hasAll = hasAllRewards();
+    if (hasAll && !m_hadAllRewards) {
+        qInfo() << "Found all device rewards, catching up on redemptions...";
+        getRedemptions();
+    }
+    m_hadAllRewards = hasAll;
+    matchDevices();
+}
+
+void Daemon::matchDevices()
+{
+    TwitchManager *twitch = m_channel->twitch();
+    if (!twitch->loggedIn()) {
+        return;
+    }
+    matchDevice(twitch->shockReward(), m_channel->shockCollar()->online(), ShockCost,
+                ShockCooldown);
+    matchDevice(twitch->smokeReward(), m_channel->smokeMachine()->online(), SmokeCost,
+                SmokeCooldown);
+}
+
+void Daemon::updatePollInterval()
+{
+    const bool connected = m_channel->twitch()->eventSub()->connected();
+    m_pollTimer->setInterval(connected ? PollInterval : FallbackPollInterval);
+}
+
+bool Daemon::hasAllRewards() const
+{
+    const TwitchManager *twitch = m_channel->twitch();
+    return twitch->shockReward().isValid() && twitch->smokeReward().isValid();
+}
+
+void Daemon::createReward(const QString &title, const int &cost, const int &cooldown)
+{
+    if (!m_channel->twitch()->loggedIn() || m_creating.contains(title)) {
+        return;
+    }
+    m_creating.insert(title);
+    qInfo() << "Creating missing reward:" << title;
+    // starts out paused, it gets enabled once its device is seen online
+    m_channel->twitch()->createReward({
+        {u"title"_qs, title},
+        {u"cost"_qs, cost},
+        {u"is_paused"_qs, true},
+        {u"is_enabled"_qs, true},
+        {u"is_global_cooldown_enabled"_qs, true},
+        {u"global_cooldown_seconds"_qs, cooldown},
+        {u"should_redemptions_skip_request_queue"_qs, false},
+    });
+}
+
+void Daemon::matchDevice(const QVariant &reward, const bool &online, const int &cost,
+                         const int &cooldown)
+{
+    if (!reward.isValid()) {
+        return;
+    }
+    const Reward current = reward.value<Reward>();
+    m_creating.remove(current.title);
+    if (current.isPaused != online) {
+        return;
+    }
+    qInfo() << (online ? "Enabling reward:" : "Pausing reward:") << current.title;
+    m_channel->twitch()->updateReward({
+        {u"id"_qs, current.id},
+        {u"cost"_qs, cost},
+        {u"is_paused"_qs, !online},
+        {u"is_global_cooldown_enabled"_qs, true},
+        {u"global_cooldown_seconds"_qs, cooldown},
+        {u"should_redemptions_skip_request_queue"_qs, false},
+    });
+}
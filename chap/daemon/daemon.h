@@ -0,0 +1,55 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <QObject>
+#include <QTimer>
+
+#include "../channel.h"
+
+/* Drives chap without a UI, everything main.qml does on its own.
+ *
+ * Fetches rewards once validated, creates the device rewards if the channel
+ * doesn't have them yet, syncs redemptions whenever the rewards show up and
+ * then on a timer as a fallback to eventsub, and pauses a device reward while
+ * its device is offline so nobody pays for something that can't happen. The
+ * channel's router takes it from there, same as in the gui. There is one of
+ * us for every channel.
+ */
+class Daemon : public QObject
+{
+    Q_OBJECT
+
+  public:
+    // redemption poll interval with and without eventsub, msecs
+    inline const static int PollInterval{60 * 1000};
+    inline const static int FallbackPollInterval{10 * 1000};
+    // what the device rewards cost and how long they cool down, seconds
+    inline const static int ShockCost{100};
+    inline const static int ShockCooldown{30};
+    inline const static int SmokeCost{1};
+    inline const static int SmokeCooldown{50};
+
+    explicit Daemon(Channel *channel, QObject *parent = nullptr);
+
+  private slots:
+    void getRedemptions();
+    void gotRewards();
+    void rewardsChanged();
+    void matchDevices();
+    void updatePollInterval();
+
+  private:
+    Channel *m_channel;
+    QTimer *m_pollTimer;
+    bool m_hadAllRewards;
+    // titles we already asked twitch to create, so a slow reply doesn't
+    // get us a duplicate
+    QSet<QString> m_creating;
+
+    bool hasAllRewards() const;
+    void createReward(const QString &title, const int &cost, const int &cooldown);
+    void matchDevice(const QVariant &reward, const bool &online, const int &cost,
+                     const int &cooldown);
+};
+
+#endif // DAEMON_H
@@ -0,0 +1,205 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLocalServer>
+#include <QSocketNotifier>
+
+#ifdef Q_OS_UNIX
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "../asynclogger.h"
+#include "../core.h"
+#include "../metricsserver.h"
+#include "../qtutils.h"
+#include "../rpcclient.h"
+#include "../startuptracer.h"
+#include "config.h"
+#include "daemon.h"
+
+#ifdef Q_OS_UNIX
+// signal handlers can't touch qt, they poke this and the event loop quits
+static int signalFds[2];
+
+static void quitOnSignal(QCoreApplication &app)
+{
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, signalFds) != 0) {
+        qWarning() << "Failed to set up signal handling!";
+        return;
+    }
+    QSocketNotifier *notifier = new QSocketNotifier(signalFds[1], QSocketNotifier::Read, &app);
+    QObject::connect(notifier, &QSocketNotifier::activated, &app, [&app]() {
+        char signal;
+        if (::read(signalFds[1], &signal, sizeof(signal)) > 0) {
+            qInfo() << "Got signal" << int(signal) << "shutting down...";
+        }
+        app.quit();
+    });
+
+    struct sigaction action = {};
+    action.sa_handler = [](int signal) {
+        const char byte = char(signal);
+        [[maybe_unused]] const ssize_t written = ::write(signalFds[0], &byte, sizeof(byte));
+    };
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    QElapsedTimer startup;
+    startup.start();
+    AsyncLogger::install();
+
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(APP_NAME);
+    app.setOrganizationName(ORG_NAME);
+    app.setOrganizationDomain(ORG_DOMAIN);
+    app.setApplicationVersion(PROJECT_VER);
+    qDebug() << PROJECT_NAME << "daemon version" << PROJECT_VER;
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(u"Runs chap without a UI."_qs);
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption eventSubUrlOption(
+        u"eventsub-url"_qs, u"Connect to an EventSub stand-in at <url>."_qs, u"url"_qs);
+    QCommandLineOption twitchUrlOption(
+        u"twitch-url"_qs, u"Send OAuth and Helix requests to a stand-in at <url>."_qs, u"url"_qs);
+    QCommandLineOption collarOption(u"collar"_qs, u"Shock collar is at <address>."_qs,
+                                    u"address"_qs);
+    QCommandLineOption smokeOption(u"smoke-machine"_qs, u"Smoke machine is at <address>."_qs,
+                                   u"address"_qs);
+    QCommandLineOption durationOption(u"smoke-duration"_qs,
+                                      u"Run the smoke machine for <seconds>."_qs, u"seconds"_qs);
+    QCommandLineOption metricsPortOption(
+        u"metrics-port"_qs, u"Serve prometheus metrics on localhost:<port>/metrics."_qs,
+        u"port"_qs);
+    QCommandLineOption logFileOption(u"log-file"_qs, u"Also log to <file>."_qs, u"file"_qs);
+    QCommandLineOption logMaxSizeOption(u"log-max-size"_qs,
+                                        u"Rotate the log file once it passes <MiB>."_qs,
+                                        u"MiB"_qs, u"10"_qs);
+    QCommandLineOption logBinaryOption(u"log-binary"_qs,
+                                       u"Write the log file in the compact binary format."_qs);
+    QCommandLineOption channelOption(
+        u"channel"_qs,
+        u"Also serve channel <name>, its devices optionally at <name>,<collar>,<smoke machine>."_qs,
+        u"name"_qs);
+    QCommandLineOption decodeLogOption(u"decode-log"_qs,
+                                       u"Print a binary log <file> as text and exit."_qs,
+                                       u"file"_qs);
+    parser.addOptions({eventSubUrlOption, twitchUrlOption, collarOption, smokeOption,
+                       durationOption, metricsPortOption, channelOption, logFileOption,
+                       logMaxSizeOption, logBinaryOption, decodeLogOption});
+    parser.addPositionalArgument(u"url"_qs, u"Callback url to hand to the running daemon."_qs,
+                                 u"[url]"_qs);
+    parser.process(app);
+
+    if (parser.isSet(decodeLogOption)) {
+        QFile file(parser.value(decodeLogOption));
+        const QByteArray text = file.open(QIODevice::ReadOnly) ? AsyncLogger::decode(file.readAll())
+                                                               : QByteArray();
+        if (text.isEmpty()) {
+            qCritical() << "Not a binary log:" << parser.value(decodeLogOption);
+            return 1;
+        }
+        fwrite(text.constData(), 1, text.size(), stdout);
+        return 0;
+    }
+
+    // a running daemon gets our arguments instead, that's how the login
+    // callback reaches it when there is no url handler to do it for us
+    RpcClient client;
+    if (client.connectToServer()) {
+        qInfo() << "Connected to running daemon, forwarding callbacks...";
+        for (const QString &url : parser.positionalArguments()) {
+            const RpcFrame::Status status = client.call(RpcFrame::Callback, {{u"url"_qs, url}});
+            if (status != RpcFrame::Ok) {
+                qCritical().noquote() << u"Daemon refused %1: %2"_qs.arg(
+                    url, RpcFrame::statusName(status));
+                return 1;
+            }
+        }
+        return 0;
+    }
+    if (!parser.positionalArguments().isEmpty()) {
+        qCritical() << "No running daemon to hand the callback url to!";
+        return 1;
+    }
+    // nobody answered, anything still there is left over from a crash
+    QLocalServer::removeServer(RpcFrame::SocketName);
+    // only once we know we're the one running, a second instance would
+    // rotate the file out from under the first
+    if (parser.isSet(logFileOption)) {
+        const qint64 maxBytes = parser.value(logMaxSizeOption).toLongLong() * 1024 * 1024;
+        if (!AsyncLogger::logToFile(parser.value(logFileOption), maxBytes,
+                                    parser.isSet(logBinaryOption))) {
+            qWarning() << "Failed to open log file:" << parser.value(logFileOption);
+        }
+    }
+
+#ifdef Q_OS_UNIX
+    quitOnSignal(app);
+#endif
+
+    StartupTracer::begin(u"core"_qs);
+    Core *core = new Core(&app);
+    StartupTracer::end(u"core"_qs);
+    QObject::connect(core->startup(), &StartupPipeline::stepFinished, core,
+                     [](const QString &name) {
+                         if (name == u"ready"_qs) {
+                             qDebug().noquote() << StartupTracer::summary();
+                         }
+                     });
+    for (const QString &value : parser.values(channelOption)) {
+        const QStringList fields = value.split(u',');
+        Channel *channel = core->addChannel(fields.value(0));
+        if (!channel) {
+            return 1;
+        }
+        if (!fields.value(1).isEmpty()) {
+            channel->shockCollar()->setIpAddress(fields.value(1));
+        }
+        if (!fields.value(2).isEmpty()) {
+            channel->smokeMachine()->setIpAddress(fields.value(2));
+        }
+    }
+    // every channel takes the same stand-ins, they don't tell users apart
+    for (Channel *channel : core->channels()) {
+        if (parser.isSet(eventSubUrlOption)) {
+            channel->twitch()->useEventSubStandIn(QUrl(parser.value(eventSubUrlOption)));
+        }
+        if (parser.isSet(twitchUrlOption)) {
+            channel->twitch()->useTwitchStandIn(QUrl(parser.value(twitchUrlOption)));
+        }
+    }
+    if (parser.isSet(collarOption)) {
+        core->shockCollar()->setIpAddress(parser.value(collarOption));
+    }
+    if (parser.isSet(smokeOption)) {
+        core->smokeMachine()->setIpAddress(parser.value(smokeOption));
+    }
+    if (parser.isSet(durationOption)) {
+        core->smokeMachine()->setDuration(qBound(1, parser.value(durationOption).toInt(), 90));
+    }
+    if (parser.isSet(metricsPortOption)) {
+        MetricsServer *metrics = new MetricsServer(core, &app);
+        metrics->listen(parser.value(metricsPortOption).toUShort());
+    }
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, core, [&]() { core->save(); });
+
+    for (Channel *channel : core->channels()) {
+        new Daemon(channel, channel);
+    }
+    QObject::connect(core, &Core::channelAdded, core,
+                     [](Channel *channel) { new Daemon(channel, channel); });
+
+    qInfo() << "Started in" << startup.elapsed() << "ms";
+    return app.exec();
+}
@@ -0,0 +1,235 @@
+#include "eventsubclient.h"
+
+#include <QJsonDocument>
+
+EventSubClient::EventSubClient(QObject *parent)
+    : QObject{parent}
+    , m_socket(nullptr)
+    , m_handoverSocket(nullptr)
+    , m_keepaliveTimer(new QTimer(this))
+    , m_reconnectTimer(new QTimer(this))
+    , m_sessionId()
+    , m_reconnectAttempts(0)
+    , m_recentMessageIds()
+    , m_connected(false)
+    , m_url(DefaultUrl)
+{
+    // twitch tells us how long it may go quiet in the welcome message, if we
+    // hear nothing for longer than that the connection is dead
+    connect(m_keepaliveTimer, &QTimer::timeout, this, &EventSubClient::keepaliveExpired);
+    m_keepaliveTimer->setSingleShot(true);
+
+    connect(m_reconnectTimer, &QTimer::timeout, this, &EventSubClient::open);
+    m_reconnectTimer->setSingleShot(true);
+}
+
+QWebSocket *EventSubClient::createSocket()
+{
+    QWebSocket *socket = new QWebSocket(QString(), QWebSocketProtocol::VersionLatest, this);
+    connect(socket, &QWebSocket::textMessageReceived, this,
+            &EventSubClient::socketMessageReceived);
+    connect(socket, &QWebSocket::stateChanged, this, [this](QAbstractSocket::SocketState state) {
+        if (state == QAbstractSocket::UnconnectedState) {
+            socketDisconnected();
+        }
+    });
+    return socket;
+}
+
+void EventSubClient::open()
+{
+    if (m_socket) {
+        qDebug() << "EventSub already open.";
+        return;
+    }
+
+    m_reconnectTimer->stop();
+    qInfo() << "Connecting to EventSub:" << m_url;
+    m_socket = createSocket();
+    m_socket->open(m_url);
+    // we should get a welcome within 10 seconds or something is wrong
+    m_keepaliveTimer->start(10 * 1000);
+}
+
+void EventSubClient::close()
+{
+    m_reconnectTimer->stop();
+    m_keepaliveTimer->stop();
+    // let go of the sockets right away, an open() straight after starts a
+    // fresh one instead of finding the old one still shutting down
+    const bool wasOpen = m_socket != nullptr;
+    retire(m_handoverSocket);
+    retire(m_socket);
+    m_handoverSocket = nullptr;
+    m_socket = nullptr;
+    m_sessionId.clear();
+    setConnected(false);
+    if (wasOpen) {
+        qInfo() << "EventSub closed.";
+    }
+}
+
+void EventSubClient::retire(QWebSocket *socket)
+{
+    if (!socket) {
+        return;
+    }
+    // nothing it does from here on is our business, it gets a moment to
+    // close cleanly before it's cut off
+    socket->disconnect(this);
+    connect(socket, &QWebSocket::disconnected, socket, &QObject::deleteLater);
+    QTimer::singleShot(1000, socket, [socket]() {
+        socket->abort();
+        socket->deleteLater();
+    });
+    socket->close();
+}
+
+void EventSubClient::socketDisconnected()
+{
+    QWebSocket *socket = qobject_cast<QWebSocket *>(QObject::sender());
+    if (socket == nullptr) {
+        return;
+    }
+    socket->deleteLater();
+
+    if (socket == m_handoverSocket) {
+        // the old connection is still good, twitch will just close it later
+        qWarning() << "EventSub reconnect failed:" << socket->closeReason();
+        m_handoverSocket = nullptr;
+        return;
+    }
+    if (socket != m_socket) {
+        return; // old session we already handed over from
+    }
+
+    m_socket = nullptr;
+    m_sessionId.clear();
+    m_keepaliveTimer->stop();
+    setConnected(false);
+    qWarning() << "EventSub disconnected:" << socket->closeCode() << socket->closeReason();
+    scheduleReconnect();
+}
+
+void EventSubClient::scheduleReconnect()
+{
+    // back off 1, 2, 4... seconds up to a minute between attempts
+    const int delay = qMin(1000 << qMin(m_reconnectAttempts, 6), 60 * 1000);
+    m_reconnectAttempts++;
+    qInfo() << "Reconnecting to EventSub in" << delay << "ms...";
+    m_reconnectTimer->start(delay);
+}
+
+void EventSubClient::keepaliveExpired()
+{
+    qWarning() << "EventSub keepalive expired!";
+    if (m_socket) {
+        // abort to skip the close handshake, the socket disconnect handler
+        // takes care of scheduling the reconnect
+        m_socket->abort();
+    }
+}
+
+void EventSubClient::socketMessageReceived(const QString &message)
+{
+    QWebSocket *socket = qobject_cast<QWebSocket *>(QObject::sender());
+    const QJsonObject root = QJsonDocument::fromJson(message.toUtf8()).object();
+    const QJsonObject metadata = root.value(u"metadata"_qs).toObject();
+    const QJsonObject payload = root.value(u"payload"_qs).toObject();
+
+    // any message counts as a sign of life for the active session
+    if (socket == m_socket && !m_sessionId.isEmpty()) {
+        m_keepaliveTimer->start();
+    }
+
+    const QString messageId = metadata.value(u"message_id"_qs).toString();
+    if (!messageId.isEmpty()) {
+        if (m_recentMessageIds.contains(messageId)) {
+            qDebug() << "Dropping duplicate EventSub message:" << messageId;
+            return;
+        }
+        m_recentMessageIds.append(messageId);
+        if (m_recentMessageIds.size() > 100) {
+            m_recentMessageIds.removeFirst();
+        }
+    }
+
+    const QString type = metadata.value(u"message_type"_qs).toString();
+    if (type == u"session_welcome"_qs) {
+        handleWelcome(socket, payload.value(u"session"_qs).toObject());
+    } else if (type == u"session_keepalive"_qs) {
+        // nothing to do, just resetting the keepalive timer is enough
+    } else if (type == u"notification"_qs) {
+        handleNotification(metadata, payload);
+    } else if (type == u"session_reconnect"_qs) {
+        handleReconnect(payload.value(u"session"_qs).toObject());
+    } else if (type == u"revocation"_qs) {
+        const QJsonObject subscription = payload.value(u"subscription"_qs).toObject();
+        const QString subType = subscription.value(u"type"_qs).toString();
+        const QString status = subscription.value(u"status"_qs).toString();
+        qWarning() << "EventSub subscription revoked:" << subType << status;
+        emit revoked(subType, status);
+    } else {
+        qWarning() << "Unknown EventSub message type:" << type;
+    }
+}
+
+void EventSubClient::handleWelcome(QWebSocket *socket, const QJsonObject &session)
+{
+    const QString sessionId = session.value(u"id"_qs).toString();
+    const int keepalive = session.value(u"keepalive_timeout_seconds"_qs).toInt(10);
+    bool handover = false;
+
+    if (socket == m_handoverSocket) {
+        // new connection is live, so we can retire the old one, twitch moves
+        // all of our subscriptions over for us
+        QWebSocket *old = m_socket;
+        m_socket = m_handoverSocket;
+        m_handoverSocket = nullptr;
+        if (old) {
+            old->close();
+        }
+        handover = true;
+    } else if (socket != m_socket) {
+        return;
+    }
+
+    m_sessionId = sessionId;
+    m_reconnectAttempts = 0;
+    // give twitch a little grace past the advertised keepalive window
+    m_keepaliveTimer->start((keepalive + 2) * 1000);
+    setConnected(true);
+    qInfo() << "EventSub session ready:" << sessionId << (handover ? "(handover)" : "");
+    emit welcomed(sessionId, handover);
+}
+
+void EventSubClient::handleNotification(const QJsonObject &metadata, const QJsonObject &payload)
+{
+    const QString type = metadata.value(u"subscription_type"_qs).toString();
+    const QJsonObject event = payload.value(u"event"_qs).toObject();
+    emit notification(type, event);
+
+    if (type == RedemptionAddType) {
+        emit redemptionAdded(event);
+    } else {
+        qDebug() << "Unhandled EventSub notification:" << type;
+    }
+}
+
+void EventSubClient::handleReconnect(const QJsonObject &session)
+{
+    const QUrl reconnectUrl(session.value(u"reconnect_url"_qs).toString());
+    if (!reconnectUrl.isValid()) {
+        qWarning() << "EventSub reconnect requested without a url!";
+        return;
+    }
+    if (m_handoverSocket) {
+        m_handoverSocket->abort();
+    }
+
+    // keep the current socket running until the new one is welcomed so we
+    // don't miss any notifications during the handover
+    qInfo() << "EventSub handing over to:" << reconnectUrl;
+    m_handoverSocket = createSocket();
+    m_handoverSocket->open(reconnectUrl);
+}
@@ -0,0 +1,66 @@
+#ifndef EVENTSUBCLIENT_H
+#define EVENTSUBCLIENT_H
+
+#include <QJsonObject>
+#include <QObject>
+#include <QWebSocket>
+
+#include "qmlsupport.h"
+#include "qtutils.h"
+
+class EventSubClient : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Backend only.")
+
+  public:
+    // twitch hosted websocket transport for eventsub
+    inline const static QUrl DefaultUrl{u"wss://eventsub.wss.twitch.tv/ws"_qs};
+    // subscription type for channel point redemptions
+    inline const static QString RedemptionAddType{
+        u"channel.channel_points_custom_reward_redemption.add"_qs};
+
+    explicit EventSubClient(QObject *parent = nullptr);
+
+    QString sessionId() const { return m_sessionId; }
+
+  signals:
+    // a session is ready, if this follows a session_reconnect handover then
+    // all existing subscriptions carried over and nothing needs re-creating
+    void welcomed(const QString &sessionId, bool handover);
+    void notification(const QString &type, const QJsonObject &event);
+    void redemptionAdded(const QJsonObject &event);
+    void revoked(const QString &type, const QString &status);
+
+  public slots:
+    void open();
+    void close();
+
+  private slots:
+    void socketDisconnected();
+    void socketMessageReceived(const QString &message);
+    void keepaliveExpired();
+
+  private:
+    QWebSocket *m_socket;
+    QWebSocket *m_handoverSocket;
+    QTimer *m_keepaliveTimer;
+    QTimer *m_reconnectTimer;
+    QString m_sessionId;
+    int m_reconnectAttempts;
+    // twitch may resend messages, remember recent ids so we can drop them
+    QList<QString> m_recentMessageIds;
+
+    QWebSocket *createSocket();
+    void retire(QWebSocket *socket);
+    void scheduleReconnect();
+    void handleWelcome(QWebSocket *socket, const QJsonObject &session);
+    void handleNotification(const QJsonObject &metadata, const QJsonObject &payload);
+    void handleReconnect(const QJsonObject &session);
+
+    RO_PROP(bool, connected, setConnected)
+    RW_PROP(QUrl, url, setUrl)
+};
+
+#endif // EVENTSUBCLIENT_H
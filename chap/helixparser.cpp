@@ -0,0 +1,432 @@
+#include "helixparser.h"
+
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// forward only reader over a JSON buffer, every read skips leading whitespace
+// and returns false on anything malformed
+class Reader
+{
+  public:
+    explicit Reader(const QByteArray &json)
+        : m_pos(json.constData())
+        , m_end(json.constData() + json.size())
+    {
+    }
+
+    bool atEnd()
+    {
+        skipSpace();
+        return m_pos == m_end;
+    }
+
+    bool consume(const char &c)
+    {
+        skipSpace();
+        if (m_pos == m_end || *m_pos != c) {
+            return false;
+        }
+        ++m_pos;
+        return true;
+    }
+
+    bool peekNull()
+    {
+        skipSpace();
+        if (m_end - m_pos >= 4 && std::memcmp(m_pos, "null", 4) == 0) {
+            m_pos += 4;
+            return true;
+        }
+        return false;
+    }
+
+    // calls member(key, size) for every key, which must read or skip the value
+    template <typename F> bool members(F member)
+    {
+        if (!consume('{')) {
+            return false;
+        }
+        if (consume('}')) {
+            return true;
+        }
+        do {
+            const char *key = nullptr;
+            qsizetype size = 0;
+            if (!rawString(key, size) || !consume(':') || !member(key, size)) {
+                return false;
+            }
+        } while (consume(','));
+        return consume('}');
+    }
+
+    // calls element() for every element, which must read or skip the value
+    template <typename F> bool elements(F element)
+    {
+        if (!consume('[')) {
+            return false;
+        }
+        if (consume(']')) {
+            return true;
+        }
+        do {
+            if (!element()) {
+                return false;
+            }
+        } while (consume(','));
+        return consume(']');
+    }
+
+    bool readString(QString &out)
+    {
+        if (peekNull()) {
+            out.clear();
+            return true;
+        }
+        const char *start = nullptr;
+        qsizetype size = 0;
+        if (!rawString(start, size)) {
+            return false;
+        }
+        // most strings have nothing escaped and can be decoded in one go
+        if (!std::memchr(start, '\\', size)) {
+            out = QString::fromUtf8(start, size);
+            return true;
+        }
+        return unescape(start, size, out);
+    }
+
+    bool readInt(int &out)
+    {
+        if (peekNull()) {
+            out = 0;
+            return true;
+        }
+        skipSpace();
+        bool negative = false;
+        if (m_pos != m_end && *m_pos == '-') {
+            negative = true;
+            ++m_pos;
+        }
+        if (m_pos == m_end || *m_pos < '0' || *m_pos > '9') {
+            return false;
+        }
+        qint64 value = 0;
+        while (m_pos != m_end && *m_pos >= '0' && *m_pos <= '9') {
+            value = qMin<qint64>(value * 10 + (*m_pos - '0'), std::numeric_limits<int>::max());
+            ++m_pos;
+        }
+        out = static_cast<int>(negative ? -value : value);
+        // anything fractional is just dropped
+        skipScalar();
+        return true;
+    }
+
+    bool readBool(bool &out)
+    {
+        skipSpace();
+        if (m_end - m_pos >= 4 && std::memcmp(m_pos, "true", 4) == 0) {
+            m_pos += 4;
+            out = true;
+            return true;
+        }
+        if (m_end - m_pos >= 5 && std::memcmp(m_pos, "false", 5) == 0) {
+            m_pos += 5;
+            out = false;
+            return true;
+        }
+        if (peekNull()) {
+            out = false;
+            return true;
+        }
+        return false;
+    }
+
+    bool readDateTime(QDateTime &out)
+    {
+        QString value;
+        if (!readString(value)) {
+            return false;
+        }
+        out = QDateTime::fromString(value, Qt::ISODateWithMs);
+        return true;
+    }
+
+    bool skipValue()
+    {
+        skipSpace();
+        if (m_pos == m_end) {
+            return false;
+        }
+        if (*m_pos == '"') {
+            const char *start = nullptr;
+            qsizetype size = 0;
+            return rawString(start, size);
+        }
+        if (*m_pos != '{' && *m_pos != '[') {
+            const char *start = m_pos;
+            skipScalar();
+            return m_pos != start;
+        }
+        // nested containers only need their brackets balanced, strings are
+        // stepped over so brackets inside them don't count
+        int depth = 0;
+        while (m_pos != m_end) {
+            const char c = *m_pos;
+            if (c == '"') {
+                const char *start = nullptr;
+                qsizetype size = 0;
+                if (!rawString(start, size)) {
+                    return false;
+                }
+                continue;
+            }
+            ++m_pos;
+            if (c == '{' || c == '[') {
+                depth++;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+  private:
+    const char *m_pos;
+    const char *m_end;
+
+    void skipSpace()
+    {
+        while (m_pos != m_end &&
+               (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t')) {
+            ++m_pos;
+        }
+    }
+
+    void skipScalar()
+    {
+        while (m_pos != m_end && *m_pos != ',' && *m_pos != '}' && *m_pos != ']' &&
+               *m_pos != ' ' && *m_pos != '\n' && *m_pos != '\r' && *m_pos != '\t') {
+            ++m_pos;
+        }
+    }
+
+    // points at the still escaped contents of the next string
+    bool rawString(const char *&start, qsizetype &size)
+    {
+        if (!consume('"')) {
+            return false;
+        }
+        start = m_pos;
+        while (m_pos != m_end) {
+            if (*m_pos == '\\') {
+                if (m_end - m_pos < 2) {
+                    break;
+                }
+                m_pos += 2;
+                continue;
+            }
+            if (*m_pos == '"') {
+                size = m_pos - start;
+                ++m_pos;
+                return true;
+            }
+            ++m_pos;
+        }
+        m_pos = m_end;
+        return false;
+    }
+
+    static bool unescape(const char *start, const qsizetype &size, QString &out)
+    {
+        out.clear();
+        out.reserve(size);
+        const char *pos = start;
+        const char *end = start + size;
+        const char *run = pos;
+        while (pos != end) {
+            if (*pos != '\\') {
+                ++pos;
+                continue;
+            }
+            out.append(QString::fromUtf8(run, pos - run));
+            if (++pos == end) {
+                return false;
+            }
+            switch (*pos++) {
+            case '"':
+                out.append(u'"');
+                break;
+            case '\\':
+                out.append(u'\\');
+                break;
+            case '/':
+                out.append(u'/');
+                break;
+            case 'b':
+                out.append(u'\b');
+                break;
+            case 'f':
+                out.append(u'\f');
+                break;
+            case 'n':
+                out.append(u'\n');
+                break;
+            case 'r':
+                out.append(u'\r');
+                break;
+            case 't':
+                out.append(u'\t');
+                break;
+            case 'u': {
+                // surrogate pairs come through as two escapes, which is
+                // exactly how QString wants them anyway
+                if (end - pos < 4) {
+                    return false;
+                }
+                bool ok = false;
+                const ushort code = QByteArray(pos, 4).toUShort(&ok, 16);
+                if (!ok) {
+                    return false;
+                }
+                out.append(QChar(code));
+                pos += 4;
+                break;
+            }
+            default:
+                return false;
+            }
+            run = pos;
+        }
+        out.append(QString::fromUtf8(run, pos - run));
+        return true;
+    }
+};
+
+inline bool is(const char *key, const qsizetype &size, const char *name)
+{
+    return size == static_cast<qsizetype>(std::strlen(name)) && std::memcmp(key, name, size) == 0;
+}
+
+bool parseReward(Reader &reader, Reward &reward)
+{
+    bool cooldownEnabled = false;
+    int cooldownSeconds = 0;
+    const bool ok = reader.members([&](const char *key, const qsizetype &size) {
+        if (is(key, size, "id")) {
+            return reader.readString(reward.id);
+        } else if (is(key, size, "title")) {
+            return reader.readString(reward.title);
+        } else if (is(key, size, "prompt")) {
+            return reader.readString(reward.prompt);
+        } else if (is(key, size, "cost")) {
+            return reader.readInt(reward.cost);
+        } else if (is(key, size, "is_enabled")) {
+            return reader.readBool(reward.isEnabled);
+        } else if (is(key, size, "is_paused")) {
+            return reader.readBool(reward.isPaused);
+        } else if (is(key, size, "should_redemptions_skip_request_queue")) {
+            return reader.readBool(reward.skipQueue);
+        } else if (is(key, size, "global_cooldown_setting")) {
+            return reader.members([&](const char *key, const qsizetype &size) {
+                if (is(key, size, "is_enabled")) {
+                    return reader.readBool(cooldownEnabled);
+                } else if (is(key, size, "global_cooldown_seconds")) {
+                    return reader.readInt(cooldownSeconds);
+                }
+                return reader.skipValue();
+            });
+        }
+        return reader.skipValue();
+    });
+    reward.cooldownSeconds = cooldownEnabled ? cooldownSeconds : 0;
+    return ok;
+}
+
+bool parseRedemption(Reader &reader, Redemption &redemption)
+{
+    const bool ok = reader.members([&](const char *key, const qsizetype &size) {
+        if (is(key, size, "id")) {
+            return reader.readString(redemption.id);
+        } else if (is(key, size, "broadcaster_id") || is(key, size, "broadcaster_user_id")) {
+            return reader.readString(redemption.broadcasterId);
+        } else if (is(key, size, "user_id")) {
+            return reader.readString(redemption.userId);
+        } else if (is(key, size, "user_login")) {
+            return reader.readString(redemption.userLogin);
+        } else if (is(key, size, "user_name")) {
+            return reader.readString(redemption.userName);
+        } else if (is(key, size, "user_input")) {
+            return reader.readString(redemption.userInput);
+        } else if (is(key, size, "status")) {
+            return reader.readString(redemption.status);
+        } else if (is(key, size, "redeemed_at")) {
+            return reader.readDateTime(redemption.redeemedAt);
+        } else if (is(key, size, "reward")) {
+            return reader.members([&](const char *key, const qsizetype &size) {
+                if (is(key, size, "id")) {
+                    return reader.readString(redemption.rewardId);
+                } else if (is(key, size, "title")) {
+                    return reader.readString(redemption.rewardTitle);
+                }
+                return reader.skipValue();
+            });
+        }
+        return reader.skipValue();
+    });
+    // eventsub sends it lowercase, helix uppercase
+    redemption.status = redemption.status.toUpper();
+    return ok;
+}
+
+} // namespace
+
+bool HelixParser::parseRewards(const QByteArray &json, QList<Reward> &rewards)
+{
+    Reader reader(json);
+    const bool ok = reader.members([&](const char *key, const qsizetype &size) {
+        if (!is(key, size, "data")) {
+            return reader.skipValue();
+        }
+        return reader.elements([&]() {
+            Reward reward;
+            if (!parseReward(reader, reward)) {
+                return false;
+            }
+            rewards.append(reward);
+            return true;
+        });
+    });
+    return ok && reader.atEnd();
+}
+
+bool HelixParser::parseRedemptions(const QByteArray &json, QList<Redemption> &redemptions,
+                                   QString *cursor)
+{
+    Reader reader(json);
+    const bool ok = reader.members([&](const char *key, const qsizetype &size) {
+        if (is(key, size, "pagination") && cursor) {
+            return reader.peekNull() ||
+                   reader.members([&](const char *key, const qsizetype &size) {
+                       if (is(key, size, "cursor")) {
+                           return reader.readString(*cursor);
+                       }
+                       return reader.skipValue();
+                   });
+        } else if (!is(key, size, "data")) {
+            return reader.skipValue();
+        }
+        return reader.elements([&]() {
+            Redemption redemption;
+            if (!parseRedemption(reader, redemption)) {
+                return false;
+            }
+            redemptions.append(redemption);
+            return true;
+        });
+    });
+    return ok && reader.atEnd();
+}
@@ -0,0 +1,29 @@
+#ifndef HELIXPARSER_H
+#define HELIXPARSER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+#include "twitchtypes.h"
+
+/* Pulls the handful of fields we use out of helix responses.
+ *
+ * Works straight off the reply bytes in a single pass, anything we don't
+ * read (images, colors, ...) is stepped over without being decoded so no
+ * QJsonDocument or QVariantMap gets built along the way. Returns false if
+ * the payload isn't the JSON we expect, anything parsed before the problem
+ * is left in the output.
+ */
+namespace HelixParser {
+
+// see https://dev.twitch.tv/docs/api/reference/#get-custom-reward
+bool parseRewards(const QByteArray &json, QList<Reward> &rewards);
+
+// see https://dev.twitch.tv/docs/api/reference/#get-custom-reward-redemption
+bool parseRedemptions(const QByteArray &json, QList<Redemption> &redemptions,
+                      QString *cursor = nullptr);
+
+} // namespace HelixParser
+
+#endif // HELIXPARSER_H
@@ -0,0 +1,284 @@
+#include "helixscheduler.h"
+
+#include <QDateTime>
+#include <QNetworkInformation>
+#include <QSet>
+#include <QtMath>
+#ifndef QT_NO_SSL
+#include <QSslConfiguration>
+#endif
+
+HelixScheduler::HelixScheduler(QNetworkAccessManager *nam, QObject *parent)
+    : QObject{parent}
+    , m_nam(nam)
+    , m_dispatchTimer(new QTimer(this))
+    , m_warmTimer(new QTimer(this))
+    , m_warmOrigins()
+    , m_lastUsed()
+    , m_queues()
+    , m_buckets()
+    , m_active()
+    , m_nextTicket(1)
+    , m_connectionsOpened(0)
+    , m_connectionsReused(0)
+    , m_http2Replies(0)
+    , m_warmUps(0)
+{
+    connect(m_dispatchTimer, &QTimer::timeout, this, &HelixScheduler::dispatch);
+    m_dispatchTimer->setSingleShot(true);
+
+    connect(m_warmTimer, &QTimer::timeout, this, &HelixScheduler::rewarm);
+    m_warmTimer->setInterval(KeepWarmInterval);
+
+    // connections from before a network change are dead, start over once
+    // we're back online instead of letting the next request find out
+    if (QNetworkInformation::load(QNetworkInformation::Feature::Reachability)) {
+        connect(QNetworkInformation::instance(), &QNetworkInformation::reachabilityChanged, this,
+                [this](QNetworkInformation::Reachability reachability) {
+                    if (reachability != QNetworkInformation::Reachability::Online) {
+                        return;
+                    }
+                    qInfo() << "Network changed, warming connections again.";
+                    m_nam->clearConnectionCache();
+                    m_lastUsed.clear();
+                    rewarm();
+                });
+    }
+}
+
+quint64 HelixScheduler::send(Priority priority, const QNetworkRequest &request,
+                             const QByteArray &verb, const QByteArray &body, Handler handler)
+{
+    const quint64 ticket = m_nextTicket++;
+    m_queues[priority].append({ticket, priority, request, verb, body, std::move(handler)});
+    // anything queued during this pass of the event loop goes out together,
+    // in priority order, instead of in the order it was asked for
+    m_dispatchTimer->start(0);
+    return ticket;
+}
+
+void HelixScheduler::cancel(const quint64 &ticket)
+{
+    QNetworkReply *reply = m_active.take(ticket);
+    if (reply) {
+        // the finished handler sees it is no longer active and cleans up
+        reply->abort();
+        return;
+    }
+    for (auto &queue : m_queues) {
+        queue.removeIf([ticket](const Request &request) { return request.ticket == ticket; });
+    }
+}
+
+void HelixScheduler::flush()
+{
+    m_dispatchTimer->stop();
+    dispatch();
+}
+
+void HelixScheduler::warmUp(const QList<QUrl> &urls)
+{
+    for (const QUrl &url : urls) {
+        QUrl origin;
+        origin.setScheme(url.scheme());
+        origin.setHost(url.host());
+        origin.setPort(url.port());
+        if (!m_warmOrigins.contains(origin)) {
+            m_warmOrigins.append(origin);
+        }
+    }
+    rewarm();
+    m_warmTimer->start();
+}
+
+void HelixScheduler::rewarm()
+{
+    for (const QUrl &origin : qAsConst(m_warmOrigins)) {
+        const QElapsedTimer lastUsed = m_lastUsed.value(origin.host());
+        if (lastUsed.isValid() && !lastUsed.hasExpired(KeepWarmInterval)) {
+            continue;
+        }
+        setWarmUps(m_warmUps + 1);
+        m_lastUsed[origin.host()].start();
+#ifndef QT_NO_SSL
+        if (origin.scheme() == u"https"_qs) {
+            // asking for h2 up front means the warmed connection is the one
+            // our HTTP/2 requests end up multiplexed over
+            QSslConfiguration ssl = QSslConfiguration::defaultConfiguration();
+            ssl.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2});
+            m_nam->connectToHostEncrypted(origin.host(), origin.port(443), ssl);
+            continue;
+        }
+#endif
+        m_nam->connectToHost(origin.host(), origin.port(80));
+    }
+}
+
+int HelixScheduler::queued() const
+{
+    int count = 0;
+    for (const auto &queue : m_queues) {
+        count += queue.size();
+    }
+    return count;
+}
+
+QString HelixScheduler::bucketKey(const QNetworkRequest &request)
+{
+    const QString tag = request.attribute(BucketAttribute).toString();
+    return tag.isEmpty() ? request.url().host() : request.url().host() + u'/' + tag;
+}
+
+HelixScheduler::Bucket &HelixScheduler::bucket(const QString &key)
+{
+    Bucket &bucket = m_buckets[key];
+    if (!bucket.refilled.isValid()) {
+        bucket.refilled.start();
+    }
+    // twitch refills the whole bucket over the course of a minute
+    const double perMsec = bucket.limit / 60000.0;
+    bucket.tokens = qMin<double>(bucket.limit, bucket.tokens + bucket.refilled.restart() * perMsec);
+    return bucket;
+}
+
+qint64 HelixScheduler::waitFor(Bucket &bucket, const Priority &priority)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (bucket.blockedUntil > now) {
+        return bucket.blockedUntil - now;
+    }
+    // reward management can't dig into the reserve, that's kept for the
+    // requests that actually get redemptions handled
+    const double reserve = priority >= Rewards ? bucket.limit * RewardsReserve : 0.0;
+    const double needed = reserve + 1.0 - bucket.tokens;
+    if (needed <= 0) {
+        return 0;
+    }
+    return qCeil(needed / (bucket.limit / 60000.0));
+}
+
+void HelixScheduler::dispatch()
+{
+    qint64 nextWait = -1;
+    for (auto &queue : m_queues) {
+        // once a bucket has to wait the rest of its requests in this queue
+        // wait too, so requests against the same bucket keep their order
+        QSet<QString> waiting;
+        for (auto iter = queue.begin(); iter != queue.end();) {
+            const QString key = bucketKey(iter->request);
+            if (waiting.contains(key)) {
+                ++iter;
+                continue;
+            }
+            const qint64 wait = waitFor(bucket(key), iter->priority);
+            if (wait > 0) {
+                waiting.insert(key);
+                nextWait = nextWait < 0 ? wait : qMin(nextWait, wait);
+                ++iter;
+                continue;
+            }
+            Request request = std::move(*iter);
+            iter = queue.erase(iter);
+            issue(std::move(request));
+        }
+    }
+    if (nextWait >= 0) {
+        m_dispatchTimer->start(nextWait);
+    }
+}
+
+void HelixScheduler::issue(Request request)
+{
+    Bucket &b = bucket(bucketKey(request.request));
+    b.tokens -= 1;
+    b.inFlight++;
+
+    m_lastUsed[request.request.url().host()].start();
+    request.request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    request.sentAt = steadyMicros();
+
+    QNetworkReply *reply;
+    if (request.verb == "GET") {
+        reply = m_nam->get(request.request);
+    } else if (request.verb == "POST") {
+        reply = m_nam->post(request.request, request.body);
+    } else {
+        reply = m_nam->sendCustomRequest(request.request, request.verb, request.body);
+    }
+    m_active.insert(request.ticket, reply);
+    // only replies that had to set up their own connection see a handshake
+    connect(reply, &QNetworkReply::encrypted, reply, [reply]() {
+        reply->setProperty("handshake", true);
+    });
+    QTimer::singleShot(5000, reply, &QNetworkReply::abort); // timeout after 5 seconds
+    connect(reply, &QNetworkReply::finished, this,
+            [this, reply, request]() { finished(reply, request); });
+}
+
+void HelixScheduler::finished(QNetworkReply *reply, Request request)
+{
+    Bucket &b = bucket(bucketKey(request.request));
+    b.inFlight--;
+    const bool cancelled = m_active.take(request.ticket) == nullptr;
+    countConnection(reply);
+
+    // twitch knows best how much of the bucket is left, we just have to
+    // account for anything else we still have in flight
+    if (reply->hasRawHeader("Ratelimit-Limit")) {
+        b.limit = qMax(1, reply->rawHeader("Ratelimit-Limit").toInt());
+    }
+    if (reply->hasRawHeader("Ratelimit-Remaining")) {
+        b.tokens = reply->rawHeader("Ratelimit-Remaining").toInt() - b.inFlight;
+    }
+
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    emit answered(request.request.url().path(), request.verb, status,
+                  steadyMicros() - request.sentAt);
+    if (status == 429 && !cancelled) {
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        qint64 resetAt = reply->rawHeader("Ratelimit-Reset").toLongLong() * 1000;
+        // back off 1, 2, 4... seconds if twitch didn't say when to come back
+        if (resetAt <= now) {
+            resetAt = now + (1000 << qMin(request.attempts, 5));
+        }
+        b.blockedUntil = qMax(b.blockedUntil, resetAt);
+        b.tokens = qMin(b.tokens, 0.0);
+        if (request.attempts < MaxRetries) {
+            qWarning() << "Rate limited, retrying" << request.request.url().path() << "in"
+                       << resetAt - now << "ms";
+            request.attempts++;
+            m_queues[request.priority].prepend(std::move(request));
+            m_dispatchTimer->start(0);
+            reply->deleteLater();
+            return;
+        }
+        qWarning() << "Rate limited, giving up on:" << request.request.url().path();
+    }
+
+    if (request.handler && !cancelled) {
+        request.handler(reply);
+    }
+    reply->deleteLater();
+    if (queued() > 0) {
+        m_dispatchTimer->start(0);
+    }
+}
+
+void HelixScheduler::countConnection(QNetworkReply *reply)
+{
+    if (reply->error() != QNetworkReply::NoError &&
+        !reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).isValid()) {
+        // never got as far as talking to the host
+        return;
+    }
+    if (reply->property("handshake").toBool()) {
+        setConnectionsOpened(m_connectionsOpened + 1);
+    } else {
+        setConnectionsReused(m_connectionsReused + 1);
+    }
+    if (reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool()) {
+        setHttp2Replies(m_http2Replies + 1);
+    }
+    qDebug() << "Connections opened:" << m_connectionsOpened << "reused:" << m_connectionsReused
+             << "http2:" << m_http2Replies;
+}
@@ -0,0 +1,132 @@
+#ifndef HELIXSCHEDULER_H
+#define HELIXSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QObject>
+#include <QTimer>
+
+#include <array>
+#include <functional>
+
+#include "qmlsupport.h"
+#include "qtutils.h"
+
+/* Central queue for every request we send to twitch.
+ *
+ * Requests are sent in priority order, each host gets a token bucket that
+ * mirrors the Ratelimit-Limit/Remaining/Reset headers twitch sends back so we
+ * can use the whole quota without being throttled, and a 429 parks the
+ * request until the bucket resets before trying it again.
+ *
+ * Handlers get the finished reply and it is deleted after they return. Every
+ * request gets a ticket that can be used to cancel it, a cancelled request
+ * never reaches its handler.
+ *
+ * Hosts handed to warmUp() get their connection opened ahead of time, again
+ * whenever the network comes back, and again if they have sat idle, so the
+ * first request after a quiet stretch doesn't pay for DNS and TLS. Requests
+ * are allowed to use HTTP/2 so everything to a host shares one connection.
+ *
+ * One scheduler can serve any number of channels. Twitch rate limits each
+ * user token on its own, so requests tagged with BucketAttribute get a bucket
+ * per host and tag instead of sharing the host's.
+ */
+class HelixScheduler : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Backend only.")
+
+  public:
+    // lower values go out first
+    enum Priority {
+        Auth,
+        Fulfillment,
+        Redemptions,
+        Rewards,
+    };
+    Q_ENUM(Priority)
+
+    using Handler = std::function<void(QNetworkReply *)>;
+
+    // twitch default for user access tokens, refilled over a minute
+    inline const static int DefaultLimit{800};
+    // share of the bucket kept back for anything more urgent than rewards
+    inline const static double RewardsReserve{0.1};
+    // times a request is retried after a 429 before giving up
+    inline const static int MaxRetries{5};
+    // warm hosts that saw no traffic for this long get reconnected, msecs
+    inline const static int KeepWarmInterval{60 * 1000};
+    // request attribute naming whose rate limit bucket a request counts against
+    inline const static QNetworkRequest::Attribute BucketAttribute{QNetworkRequest::User};
+
+    explicit HelixScheduler(QNetworkAccessManager *nam, QObject *parent = nullptr);
+
+    quint64 send(Priority priority, const QNetworkRequest &request, const QByteArray &verb,
+                 const QByteArray &body, Handler handler);
+    void cancel(const quint64 &ticket);
+    int queued() const;
+    void warmUp(const QList<QUrl> &urls);
+    // send whatever can go now instead of on the next pass of the event loop
+    void flush();
+
+  signals:
+    // every reply including the 429s that get retried, status 0 when there
+    // was no http response at all
+    void answered(const QString &path, const QByteArray &verb, const int &status,
+                  const qint64 &micros);
+
+  private slots:
+    void dispatch();
+    void rewarm();
+
+  private:
+    struct Request {
+        quint64 ticket;
+        Priority priority;
+        QNetworkRequest request;
+        QByteArray verb;
+        QByteArray body;
+        Handler handler;
+        int attempts = 0;
+        // steadyMicros() when the latest attempt went out
+        qint64 sentAt = 0;
+    };
+    struct Bucket {
+        int limit = DefaultLimit;
+        double tokens = DefaultLimit;
+        int inFlight = 0;
+        // when we may send again after a 429, msecs since epoch
+        qint64 blockedUntil = 0;
+        QElapsedTimer refilled;
+    };
+
+    QNetworkAccessManager *m_nam;
+    QTimer *m_dispatchTimer;
+    QTimer *m_warmTimer;
+    // scheme, host, and port of everything we keep warm
+    QList<QUrl> m_warmOrigins;
+    QHash<QString, QElapsedTimer> m_lastUsed;
+    std::array<QList<Request>, Rewards + 1> m_queues;
+    QHash<QString, Bucket> m_buckets;
+    QHash<quint64, QNetworkReply *> m_active;
+    quint64 m_nextTicket;
+
+    static QString bucketKey(const QNetworkRequest &request);
+    Bucket &bucket(const QString &key);
+    qint64 waitFor(Bucket &bucket, const Priority &priority);
+    void issue(Request request);
+    void finished(QNetworkReply *reply, Request request);
+    void countConnection(QNetworkReply *reply);
+
+    // replies that needed a fresh TLS handshake vs ones that rode an already
+    // open connection, a working warm-up shows up as mostly reused
+    RO_PROP(int, connectionsOpened, setConnectionsOpened)
+    RO_PROP(int, connectionsReused, setConnectionsReused)
+    RO_PROP(int, http2Replies, setHttp2Replies)
+    RO_PROP(int, warmUps, setWarmUps)
+};
+
+#endif // HELIXSCHEDULER_H
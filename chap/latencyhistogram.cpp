@@ -0,0 +1,115 @@
+#include "latencyhistogram.h"
+
+#include <QtAlgorithms>
+
+#include <cmath>
+
+// values below SubBuckets get a bucket each, every power of two above that
+// gets half as many, the first exponent past the linear range is log2 of it
+static constexpr int HalfBuckets = LatencyHistogram::SubBuckets / 2;
+static constexpr int LinearBits = 6;
+static_assert(1 << LinearBits == LatencyHistogram::SubBuckets);
+
+LatencyHistogram::LatencyHistogram(const int &slices, const qint64 &sliceMsecs)
+    : m_sliceMsecs(qMax<qint64>(1, sliceMsecs))
+    , m_clock()
+    , m_slices(qMax(1, slices))
+    , m_current(0)
+{
+    m_clock.start();
+}
+
+int LatencyHistogram::bucket(qint64 micros)
+{
+    micros = qBound<qint64>(0, micros, MaxValue - 1);
+    if (micros < SubBuckets) {
+        return static_cast<int>(micros);
+    }
+    const int exponent = 63 - qCountLeadingZeroBits(static_cast<quint64>(micros));
+    const int shift = exponent - LinearBits + 1;
+    return SubBuckets + (exponent - LinearBits) * HalfBuckets +
+           static_cast<int>((micros >> shift) - HalfBuckets);
+}
+
+qint64 LatencyHistogram::upperBound(const int &bucket)
+{
+    if (bucket < SubBuckets) {
+        return bucket;
+    }
+    const int offset = bucket - SubBuckets;
+    const int exponent = offset / HalfBuckets + LinearBits;
+    const qint64 sub = offset % HalfBuckets + HalfBuckets;
+    const int shift = exponent - LinearBits + 1;
+    return ((sub + 1) << shift) - 1;
+}
+
+int LatencyHistogram::bucketCount() { return bucket(MaxValue - 1) + 1; }
+
+bool LatencyHistogram::live(const Slice &slice, const qint64 &now) const
+{
+    return slice.startedAt >= 0 &&
+           now - slice.startedAt < m_sliceMsecs * static_cast<qint64>(m_slices.size());
+}
+
+void LatencyHistogram::record(const qint64 &micros)
+{
+    const qint64 now = m_clock.elapsed();
+    Slice *slice = &m_slices[m_current];
+    if (slice->startedAt < 0 || now - slice->startedAt >= m_sliceMsecs) {
+        // move on to the oldest slice and start it over
+        if (slice->startedAt >= 0) {
+            m_current = (m_current + 1) % m_slices.size();
+            slice = &m_slices[m_current];
+        }
+        slice->startedAt = now - (now % m_sliceMsecs);
+        slice->total = 0;
+        slice->counts.assign(bucketCount(), 0);
+    }
+    slice->counts[bucket(micros)]++;
+    slice->total++;
+}
+
+qint64 LatencyHistogram::percentile(const double &p) const
+{
+    const qint64 now = m_clock.elapsed();
+    const quint64 total = count();
+    if (total == 0) {
+        return 0;
+    }
+    // rank of the sample we're after, 1 based
+    const quint64 rank =
+        qMax<quint64>(1, static_cast<quint64>(std::ceil(qBound(0.0, p, 1.0) * total)));
+    quint64 seen = 0;
+    const int buckets = bucketCount();
+    for (int i = 0; i < buckets; i++) {
+        for (const Slice &slice : m_slices) {
+            if (live(slice, now)) {
+                seen += slice.counts[i];
+            }
+        }
+        if (seen >= rank) {
+            return upperBound(i);
+        }
+    }
+    return upperBound(buckets - 1);
+}
+
+quint64 LatencyHistogram::count() const
+{
+    const qint64 now = m_clock.elapsed();
+    quint64 total = 0;
+    for (const Slice &slice : m_slices) {
+        if (live(slice, now)) {
+            total += slice.total;
+        }
+    }
+    return total;
+}
+
+void LatencyHistogram::clear()
+{
+    for (Slice &slice : m_slices) {
+        slice = Slice();
+    }
+    m_current = 0;
+}
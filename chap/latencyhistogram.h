@@ -0,0 +1,55 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QElapsedTimer>
+#include <QtGlobal>
+
+#include <vector>
+
+/* Rolling latency histogram in microseconds.
+ *
+ * Buckets are laid out HDR style, linear up to SubBuckets and then each
+ * power of two split into SubBuckets / 2 steps, so any value is kept to
+ * within about 3% no matter how big it is and recording is a couple of shifts
+ * and an increment. The window is split into slices, the oldest slice is
+ * reused once the window has moved past it so old samples age out without
+ * keeping the samples themselves.
+ */
+class LatencyHistogram
+{
+  public:
+    inline const static int SubBuckets{64};
+    // largest value kept apart, anything above lands in the top bucket
+    inline const static qint64 MaxValue{Q_INT64_C(1) << 36};
+    // ten minutes, in a minute's worth of slices
+    inline const static int DefaultSlices{10};
+    inline const static qint64 DefaultSliceMsecs{60 * 1000};
+
+    explicit LatencyHistogram(const int &slices = DefaultSlices,
+                              const qint64 &sliceMsecs = DefaultSliceMsecs);
+
+    void record(const qint64 &micros);
+    // value at or below which p (0-1) of the samples in the window fall
+    qint64 percentile(const double &p) const;
+    quint64 count() const;
+    void clear();
+
+  private:
+    struct Slice {
+        qint64 startedAt = -1;
+        quint64 total = 0;
+        std::vector<quint32> counts;
+    };
+
+    qint64 m_sliceMsecs;
+    QElapsedTimer m_clock;
+    std::vector<Slice> m_slices;
+    size_t m_current;
+
+    static int bucket(qint64 micros);
+    static qint64 upperBound(const int &bucket);
+    static int bucketCount();
+    bool live(const Slice &slice, const qint64 &now) const;
+};
+
+#endif // LATENCYHISTOGRAM_H
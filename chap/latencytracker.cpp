@@ -0,0 +1,203 @@
+#include "latencytracker.h"
+
+#include <QDateTime>
+#include <QMetaEnum>
+
+#include "qtutils.h"
+
+static const QString DeviceNames[] = {u"all"_qs, u"shock"_qs, u"smoke"_qs};
+
+static QString stageName(const int &stage)
+{
+    const QString key =
+        QString::fromLatin1(QMetaEnum::fromType<LatencyTracker::Stage>().valueToKey(stage));
+    return key.left(1).toLower() + key.mid(1);
+}
+
+LatencyTracker::LatencyTracker(TwitchManager *twitch, ShockCollarManager *shockCollar,
+                               SmokeMachineManager *smokeMachine, QObject *parent)
+    : QObject{parent}
+    , m_channel(twitch->channel())
+    , m_summaryTimer(new QTimer(this))
+    , m_traces()
+    , m_histograms()
+{
+    connect(twitch, &TwitchManager::redemptionsReady, this, &LatencyTracker::redemptionsReady);
+    connect(twitch, &TwitchManager::redemptionUpdated, this, &LatencyTracker::redemptionUpdated);
+    connect(shockCollar, &ShockCollarManager::dispatched, this,
+            [this](const QList<QString> &ids) { dispatched(ShockCollar, ids); });
+    connect(shockCollar, &ShockCollarManager::acked, this, &LatencyTracker::deviceAcked);
+    connect(smokeMachine, &SmokeMachineManager::dispatched, this,
+            [this](const QList<QString> &ids) { dispatched(SmokeMachine, ids); });
+    connect(smokeMachine, &SmokeMachineManager::acked, this, &LatencyTracker::deviceAcked);
+
+    connect(m_summaryTimer, &QTimer::timeout, this, &LatencyTracker::logSummary);
+    m_summaryTimer->start(SummaryInterval);
+}
+
+const LatencyHistogram &LatencyTracker::histogram(const Stage &stage, const Device &device) const
+{
+    return m_histograms[device][stage];
+}
+
+QVariantMap LatencyTracker::stats() const
+{
+    QVariantMap stats;
+    for (int device = 0; device < DeviceCount; device++) {
+        QVariantMap stages;
+        for (int stage = 0; stage < StageCount; stage++) {
+            const LatencyHistogram &histogram = m_histograms[device][stage];
+            stages.insert(stageName(stage),
+                          QVariantMap{
+                              {u"count"_qs, histogram.count()},
+                              {u"p50"_qs, histogram.percentile(0.5) / 1000.0},
+                              {u"p95"_qs, histogram.percentile(0.95) / 1000.0},
+                              {u"p99"_qs, histogram.percentile(0.99) / 1000.0},
+                          });
+        }
+        stats.insert(DeviceNames[device], stages);
+    }
+    return stats;
+}
+
+void LatencyTracker::redemptionsReady(const QList<Redemption> &redemptions)
+{
+    // twitch stamps redeemed_at on its own clock, work out how long ago that
+    // was and carry it over to ours, skew can make it look negative
+    const qint64 nowMicros = steadyMicros();
+    const qint64 wallMicros = QDateTime::currentMSecsSinceEpoch() * 1000;
+    for (const Redemption &redemption : redemptions) {
+        if (redemption.fetchedAt == 0 || m_traces.contains(redemption.id)) {
+            continue;
+        }
+        Trace trace;
+        trace.fetchedAt = redemption.fetchedAt;
+        trace.parsedAt = redemption.parsedAt;
+        if (redemption.redeemedAt.isValid()) {
+            const qint64 fetchedWall = wallMicros - (nowMicros - redemption.fetchedAt);
+            const qint64 waited =
+                qMax<qint64>(0, fetchedWall - redemption.redeemedAt.toMSecsSinceEpoch() * 1000);
+            trace.redeemedAt = redemption.fetchedAt - waited;
+            record(Fetched, AnyDevice, waited);
+        }
+        record(Parsed, AnyDevice, trace.parsedAt - trace.fetchedAt);
+        m_traces.insert(redemption.id, trace);
+    }
+    forgetStale();
+}
+
+void LatencyTracker::dispatched(const Device &device, const QList<QString> &redemptionIds)
+{
+    const qint64 now = steadyMicros();
+    for (const QString &id : redemptionIds) {
+        auto it = m_traces.find(id);
+        // a retry goes out again, the first attempt is the one that counts
+        if (it == m_traces.end() || it->dispatchedAt != 0) {
+            continue;
+        }
+        it->dispatchedAt = now;
+        it->device = device;
+        record(Dispatched, device, now - it->parsedAt);
+        if (it->ackedAt != 0) {
+            record(DeviceAcked, device, qMax<qint64>(0, it->ackedAt - now));
+        }
+    }
+}
+
+void LatencyTracker::deviceAcked(const QList<QString> &redemptionIds, bool success)
+{
+    const qint64 now = steadyMicros();
+    for (const QString &id : redemptionIds) {
+        auto it = m_traces.find(id);
+        if (it == m_traces.end() || it->ackedAt != 0) {
+            continue;
+        }
+        if (!success) {
+            // the router cancels it, nothing more worth timing
+            m_traces.erase(it);
+            continue;
+        }
+        it->ackedAt = now;
+        if (it->dispatchedAt != 0) {
+            record(DeviceAcked, it->device, now - it->dispatchedAt);
+        }
+        if (it->fulfilledAt != 0) {
+            finish(it);
+        }
+    }
+}
+
+void LatencyTracker::redemptionUpdated(const QString &, const QString &id, const QString &status,
+                                       bool success)
+{
+    auto it = m_traces.find(id);
+    if (it == m_traces.end() || it->fulfilledAt != 0) {
+        return;
+    }
+    if (!success || status != u"FULFILLED"_qs) {
+        m_traces.erase(it);
+        return;
+    }
+    // twitch can hear about it before the device answers, the ack finishes
+    // the trace whenever it shows up
+    it->fulfilledAt = steadyMicros();
+    if (it->ackedAt != 0) {
+        finish(it);
+    }
+}
+
+void LatencyTracker::finish(QHash<QString, Trace>::iterator it)
+{
+    const Trace trace = *it;
+    m_traces.erase(it);
+    // fulfilled ahead of the ack counts as no wait at all
+    record(Fulfilled, trace.device, qMax<qint64>(0, trace.fulfilledAt - trace.ackedAt));
+    if (trace.redeemedAt != 0) {
+        const qint64 end = qMax(trace.fulfilledAt, trace.ackedAt);
+        record(Total, trace.device, end - trace.redeemedAt);
+    }
+}
+
+void LatencyTracker::logSummary()
+{
+    emit statsChanged();
+    if (m_histograms[AnyDevice][Parsed].count() == 0) {
+        return;
+    }
+    for (int device = 0; device < DeviceCount; device++) {
+        for (int stage = 0; stage < StageCount; stage++) {
+            const LatencyHistogram &histogram = m_histograms[device][stage];
+            if (histogram.count() == 0) {
+                continue;
+            }
+            const QString name = m_channel.isEmpty() ? QString() : m_channel + u' ';
+            qInfo().noquote() << u"Latency %1%2 %3: n %4 p50 %5 p95 %6 p99 %7 ms"_qs
+                                     .arg(name, DeviceNames[device], stageName(stage))
+                                     .arg(histogram.count())
+                                     .arg(histogram.percentile(0.5) / 1000.0, 0, 'f', 1)
+                                     .arg(histogram.percentile(0.95) / 1000.0, 0, 'f', 1)
+                                     .arg(histogram.percentile(0.99) / 1000.0, 0, 'f', 1);
+        }
+    }
+}
+
+void LatencyTracker::record(const Stage &stage, const Device &device, const qint64 &micros)
+{
+    // every sample also counts towards the totals across devices
+    m_histograms[device][stage].record(micros);
+    if (device != AnyDevice) {
+        m_histograms[AnyDevice][stage].record(micros);
+    }
+}
+
+void LatencyTracker::forgetStale()
+{
+    const qint64 cutoff = steadyMicros() - ForgetAfter * 1000;
+    for (auto it = m_traces.begin(); it != m_traces.end();) {
+        if (it->fetchedAt < cutoff) {
+            it = m_traces.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef LATENCYTRACKER_H
+#define LATENCYTRACKER_H
+
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+
+#include <array>
+
+#include "latencyhistogram.h"
+#include "qmlsupport.h"
+#include "shockcollarmanager.h"
+#include "smokemachinemanager.h"
+#include "twitchmanager.h"
+
+/* Follows redemptions through every stage between the viewer and the device.
+ *
+ * Each redemption is timed from twitch's redeemed_at to us getting it, to
+ * having parsed it, to the device request going out, to the device answering
+ * and to twitch acknowledging the fulfillment. The time spent in each stage
+ * goes into a rolling histogram, one set overall and one per device, and a
+ * summary is logged every so often and handed to qml from stats().
+ */
+class LatencyTracker : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Backend only.")
+
+  public:
+    // each is the time spent getting there from the stage before
+    enum Stage {
+        Fetched,
+        Parsed,
+        Dispatched,
+        DeviceAcked,
+        Fulfilled,
+        // redeemed_at all the way to fulfilled
+        Total,
+        StageCount,
+    };
+    Q_ENUM(Stage)
+
+    enum Device {
+        AnyDevice,
+        ShockCollar,
+        SmokeMachine,
+        DeviceCount,
+    };
+    Q_ENUM(Device)
+
+    // how often the summary is logged and stats() is refreshed, msecs
+    inline const static int SummaryInterval{60 * 1000};
+    // redemptions that never finish are forgotten after this, msecs
+    inline const static qint64 ForgetAfter{10 * 60 * 1000};
+
+    explicit LatencyTracker(TwitchManager *twitch, ShockCollarManager *shockCollar,
+                            SmokeMachineManager *smokeMachine, QObject *parent = nullptr);
+
+    const LatencyHistogram &histogram(const Stage &stage, const Device &device = AnyDevice) const;
+    // per device, per stage, count and p50/p95/p99 in msecs
+    Q_INVOKABLE QVariantMap stats() const;
+
+    // from our devices or a channel sharing them, only ours are timed
+    void dispatched(const Device &device, const QList<QString> &redemptionIds);
+    void deviceAcked(const QList<QString> &redemptionIds, bool success);
+
+  signals:
+    void statsChanged();
+
+  public slots:
+    void logSummary();
+
+  private slots:
+    void redemptionsReady(const QList<Redemption> &redemptions);
+    void redemptionUpdated(const QString &rewardId, const QString &id, const QString &status,
+                           bool success);
+
+  private:
+    // stage times in steadyMicros(), zero until reached, redeemedAt is
+    // twitch's wall clock moved over onto ours
+    struct Trace {
+        qint64 redeemedAt = 0;
+        qint64 fetchedAt = 0;
+        qint64 parsedAt = 0;
+        qint64 dispatchedAt = 0;
+        qint64 ackedAt = 0;
+        qint64 fulfilledAt = 0;
+        Device device = AnyDevice;
+    };
+
+    // only there to tell the channels apart in the log
+    QString m_channel;
+    QTimer *m_summaryTimer;
+    QHash<QString, Trace> m_traces;
+    std::array<std::array<LatencyHistogram, StageCount>, DeviceCount> m_histograms;
+
+    // once both the device and twitch have answered, in whichever order
+    void finish(QHash<QString, Trace>::iterator it);
+    void record(const Stage &stage, const Device &device, const qint64 &micros);
+    void forgetStale();
+};
+
+#endif // LATENCYTRACKER_H
@@ -1,24 +1,35 @@
+#include <QCommandLineParser>
 #include <QDir>
 #include <QFontDatabase>
 #include <QGuiApplication>
 #include <QIcon>
-#include <QLocalSocket>
+#include <QJsonDocument>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
 #include <QQuickStyle>
+#include <QQuickWindow>
 
+#include <algorithm>
+
+#include "asynclogger.h"
 #include "config.h"
 #include "core.h"
+#include "metricsserver.h"
 #include "qtutils.h"
+#include "rpcclient.h"
+#include "startuptracer.h"
+
+static const QString FontPrefix = u":/chap/resources/Fira_Code/"_qs;
+// the window only ever asks for the regular weight, the rest can wait until
+// after the first frame instead of holding it up
+static const QString CriticalFont = u"FiraCode-Regular.ttf"_qs;
 
-bool registerFonts()
+bool registerFonts(const QStringList &files)
 {
     bool success = true;
-    QString prefix;
 
-    prefix = u":/chap/resources/Fira_Code/"_qs;
-    for (const QString &f : QDir(prefix).entryList({u"*.ttf"_qs})) {
-        if (QFontDatabase::addApplicationFont(prefix + f) == -1)
+    for (const QString &f : files) {
+        if (QFontDatabase::addApplicationFont(FontPrefix + f) == -1)
             success = false;
     }
 
@@ -27,27 +38,30 @@ bool registerFonts()
 
 int main(int argc, char *argv[])
 {
-    qInstallMessageHandler(messageHandler);
+    StartupTracer::begin(u"messageHandler"_qs);
+    AsyncLogger::install();
+    StartupTracer::end(u"messageHandler"_qs);
 
 #ifdef Q_OS_WIN
-    // check for other running instance on windows
-    QLocalSocket socket = QLocalSocket();
-    socket.connectToServer(u"chap-rpc"_qs);
-    if (socket.waitForConnected(1000)) {
-        qDebug() << "Connected to other instance, sending arguments:" << argv;
-        QByteArray out;
-        QDataStream stream(&out, QIODevice::WriteOnly);
-        stream << argc;
-        for (int i = 0; i < argc; i++) {
-            stream << argv[i];
+    // check for other running instance on windows, pipe names are global so
+    // a startup report run would find the real one, it never hands off
+    const bool reporting = std::any_of(argv + 1, argv + argc, [](const char *arg) {
+        return QByteArray(arg).startsWith("--startup-report");
+    });
+    RpcClient client;
+    if (!reporting && client.connectToServer()) {
+        qDebug() << "Connected to other instance, forwarding callbacks";
+        for (int i = 1; i < argc; i++) {
+            const QString arg = QString::fromLocal8Bit(argv[i]);
+            if (arg.startsWith(u"chap:"_qs)) {
+                client.call(RpcFrame::Callback, {{u"url"_qs, arg}});
+            }
         }
-        socket.write(out);
-        socket.waitForBytesWritten();
-        socket.close();
         return 0;
     }
 #endif
 
+    StartupTracer::begin(u"app"_qs);
     QGuiApplication app(argc, argv);
     app.setApplicationName(APP_NAME);
     app.setOrganizationName(ORG_NAME);
@@ -55,21 +69,56 @@ int main(int argc, char *argv[])
     app.setApplicationVersion(PROJECT_VER);
     app.setWindowIcon(QIcon(u":/chap/resources/icon.png"_qs));
     QQuickStyle::setStyle(u"Basic"_qs);
+    StartupTracer::end(u"app"_qs);
     qDebug() << PROJECT_NAME << "version" << PROJECT_VER;
 
-    qDebug() << "Registering custom fonts...";
-    if (!registerFonts()) {
-        qWarning() << "Failed to register custom fonts!";
-    } else {
-#ifdef Q_OS_WIN
-        app.setFont({u"Fira Code"_qs, 10, QFont::Normal});
-#else
-        app.setFont({u"Fira Code"_qs, 13, QFont::Normal});
-#endif
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption eventSubUrlOption(
+        u"eventsub-url"_qs, u"Connect to an EventSub stand-in at <url>."_qs, u"url"_qs);
+    QCommandLineOption twitchUrlOption(
+        u"twitch-url"_qs, u"Send OAuth and Helix requests to a stand-in at <url>."_qs, u"url"_qs);
+    QCommandLineOption metricsPortOption(
+        u"metrics-port"_qs, u"Serve prometheus metrics on localhost:<port>/metrics."_qs,
+        u"port"_qs);
+    QCommandLineOption logFileOption(u"log-file"_qs, u"Also log to <file>."_qs, u"file"_qs);
+    QCommandLineOption logMaxSizeOption(u"log-max-size"_qs,
+                                        u"Rotate the log file once it passes <MiB>."_qs,
+                                        u"MiB"_qs, u"10"_qs);
+    QCommandLineOption logBinaryOption(u"log-binary"_qs,
+                                       u"Write the log file in the compact binary format."_qs);
+    QCommandLineOption startupReportOption(
+        u"startup-report"_qs, u"Write startup timings to <file> and quit once drawn."_qs,
+        u"file"_qs);
+    parser.addOptions({eventSubUrlOption, twitchUrlOption, metricsPortOption, logFileOption,
+                       logMaxSizeOption, logBinaryOption, startupReportOption});
+    parser.addPositionalArgument(u"url"_qs, u"Callback url to handle."_qs, u"[url]"_qs);
+    parser.process(app);
+    if (parser.isSet(logFileOption)) {
+        const qint64 maxBytes = parser.value(logMaxSizeOption).toLongLong() * 1024 * 1024;
+        if (!AsyncLogger::logToFile(parser.value(logFileOption), maxBytes,
+                                    parser.isSet(logBinaryOption))) {
+            qWarning() << "Failed to open log file:" << parser.value(logFileOption);
+        }
     }
 
     qDebug() << "Setting up backend...";
+    StartupTracer::begin(u"core"_qs);
     Core *core = new Core(&app);
+    StartupTracer::end(u"core"_qs);
+    for (Channel *channel : core->channels()) {
+        if (parser.isSet(eventSubUrlOption)) {
+            channel->twitch()->useEventSubStandIn(QUrl(parser.value(eventSubUrlOption)));
+        }
+        if (parser.isSet(twitchUrlOption)) {
+            channel->twitch()->useTwitchStandIn(QUrl(parser.value(twitchUrlOption)));
+        }
+    }
+    if (parser.isSet(metricsPortOption)) {
+        MetricsServer *metrics = new MetricsServer(core, &app);
+        metrics->listen(parser.value(metricsPortOption).toUShort());
+    }
 
     QObject::connect(&app, &QGuiApplication::aboutToQuit, core, [&]() { core->save(); });
 
@@ -79,8 +128,25 @@ int main(int argc, char *argv[])
     ctx->setContextProperty(u"twitch"_qs, core->twitch());
     ctx->setContextProperty(u"shockCollar"_qs, core->shockCollar());
     ctx->setContextProperty(u"smokeMachine"_qs, core->smokeMachine());
+    ctx->setContextProperty(u"latency"_qs, core->latency());
+
+    // the window is the only thing waiting on fonts and qml, they are added
+    // after the backend's steps so its requests are out before loading blocks
+    StartupPipeline *startup = core->startup();
+    startup->add(u"fonts"_qs, {}, [&app](StartupPipeline::Done done) {
+        qDebug() << "Registering custom fonts...";
+        if (!registerFonts({CriticalFont})) {
+            qWarning() << "Failed to register custom fonts!";
+        } else {
+#ifdef Q_OS_WIN
+            app.setFont({u"Fira Code"_qs, 10, QFont::Normal});
+#else
+            app.setFont({u"Fira Code"_qs, 13, QFont::Normal});
+#endif
+        }
+        done();
+    });
 
-    qDebug() << "Loading QML...";
     const QUrl url(u"qrc:/chap/qml/main.qml"_qs);
     QObject::connect(
         &engine, &QQmlApplicationEngine::objectCreated, &app,
@@ -91,7 +157,49 @@ int main(int argc, char *argv[])
             }
         },
         Qt::QueuedConnection);
-    engine.load(url);
+    startup->add(u"qml"_qs, {u"fonts"_qs},
+                 [&engine, &app, startup, url](StartupPipeline::Done done) {
+        qDebug() << "Loading QML...";
+        engine.load(url);
+        const qint64 loadedAt = steadyMicros();
+        // nothing renders until we are back in the event loop, so this can't miss it
+        QQuickWindow *window = qobject_cast<QQuickWindow *>(engine.rootObjects().value(0));
+        if (window) {
+            QObject::connect(
+                window, &QQuickWindow::frameSwapped, &app,
+                [startup, loadedAt]() {
+                    StartupTracer::record(u"firstFrame"_qs, loadedAt, steadyMicros());
+                    startup->add(u"fonts.deferred"_qs, {}, [](StartupPipeline::Done done) {
+                        QStringList fonts = QDir(FontPrefix).entryList({u"*.ttf"_qs});
+                        fonts.removeAll(CriticalFont);
+                        if (!registerFonts(fonts)) {
+                            qWarning() << "Failed to register deferred fonts!";
+                        }
+                        done();
+                    });
+                },
+                Qt::SingleShotConnection);
+        }
+        done();
+    });
+
+    // everything main() cares about is in once the deferred fonts are
+    const QString startupReport = parser.value(startupReportOption);
+    QObject::connect(startup, &StartupPipeline::stepFinished, &app,
+                     [&app, startupReport](const QString &name) {
+                         if (name != u"fonts.deferred"_qs) {
+                             return;
+                         }
+                         qInfo().noquote() << StartupTracer::summary();
+                         if (startupReport.isEmpty()) {
+                             return;
+                         }
+                         if (!writeFileAtomic(startupReport,
+                                              QJsonDocument(StartupTracer::report()).toJson())) {
+                             qWarning() << "Failed to write startup report:" << startupReport;
+                         }
+                         app.quit();
+                     });
 
     qDebug() << "Starting application...";
     return app.exec();
@@ -0,0 +1,307 @@
+#include "metricsserver.h"
+
+#include <utility>
+
+#include "asynclogger.h"
+
+static QString escape(QString value)
+{
+    return value.replace(u'\\', u"\\\\"_qs).replace(u'"', u"\\\""_qs).replace(u'\n', u"\\n"_qs);
+}
+
+static QString number(const double &value) { return QString::number(value, 'g', 10); }
+
+// one sample line, labels are already rendered
+static void sample(QString &out, const QString &name, const QString &labels, const double &value)
+{
+    out += name;
+    if (!labels.isEmpty()) {
+        out += u"{%1}"_qs.arg(labels);
+    }
+    out += u" %1\n"_qs.arg(number(value));
+}
+
+static void header(QString &out, const QString &name, const QString &type, const QString &help)
+{
+    out += u"# HELP %1 %2\n# TYPE %1 %3\n"_qs.arg(name, help, type);
+}
+
+void MetricsServer::Histogram::observe(const double &seconds)
+{
+    for (size_t i = 0; i < LatencyBuckets.size(); i++) {
+        if (seconds <= LatencyBuckets[i]) {
+            buckets[i]++;
+        }
+    }
+    count++;
+    sum += seconds;
+}
+
+// prometheus wants the buckets cumulative, observe() already counts them so
+static void histogram(QString &out, const QString &name, const QString &labels,
+                      const std::vector<quint64> &buckets, const quint64 &count,
+                      const double &sum)
+{
+    const QString prefix = labels.isEmpty() ? QString() : labels + u',';
+    for (size_t i = 0; i < buckets.size(); i++) {
+        sample(out, name + u"_bucket"_qs,
+               prefix + u"le=\"%1\""_qs.arg(number(MetricsServer::LatencyBuckets[i])),
+               buckets[i]);
+    }
+    sample(out, name + u"_bucket"_qs, prefix + u"le=\"+Inf\""_qs, count);
+    sample(out, name + u"_sum"_qs, labels, sum);
+    sample(out, name + u"_count"_qs, labels, count);
+}
+
+MetricsServer::MetricsServer(Core *core, QObject *parent)
+    : QObject{parent}
+    , m_core(core)
+    , m_server(new QTcpServer(this))
+    , m_lagTimer(new QTimer(this))
+    , m_lagClock()
+    , m_helixRequests()
+    , m_helixLatency()
+    , m_refreshes()
+    , m_refreshFailures()
+    , m_pings()
+    , m_lastPing()
+    , m_lag()
+    , m_lastLag(0)
+{
+    connect(m_server, &QTcpServer::newConnection, this, &MetricsServer::newConnection);
+
+    connect(m_core->scheduler(), &HelixScheduler::answered, this,
+            [this](const QString &path, const QByteArray &verb, const int &status,
+                   const qint64 &micros) {
+                const QString endpoint = u"endpoint=\"%1\",method=\"%2\""_qs.arg(
+                    escape(path), QString::fromLatin1(verb));
+                m_helixRequests[endpoint + u",status=\"%1\""_qs.arg(status)]++;
+                m_helixLatency[endpoint].observe(micros / 1e6);
+            });
+    for (Channel *channel : m_core->channels()) {
+        watch(channel);
+    }
+    connect(m_core, &Core::channelAdded, this, &MetricsServer::watch);
+
+    // a precise timer fires on time unless something is hogging the loop
+    connect(m_lagTimer, &QTimer::timeout, this, &MetricsServer::checkLag);
+    m_lagTimer->setTimerType(Qt::PreciseTimer);
+    m_lagTimer->start(LagInterval);
+    m_lagClock.start();
+}
+
+bool MetricsServer::listen(const quint16 &port)
+{
+    if (!m_server->listen(QHostAddress::LocalHost, port)) {
+        qWarning() << "Metrics failed to listen on port" << port << m_server->errorString();
+        return false;
+    }
+    qInfo() << "Serving metrics on"
+            << u"http://127.0.0.1:%1/metrics"_qs.arg(m_server->serverPort());
+    return true;
+}
+
+void MetricsServer::newConnection()
+{
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QTcpSocket::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { readRequest(socket); });
+    }
+}
+
+void MetricsServer::readRequest(QTcpSocket *socket)
+{
+    // all we care about is the request line, wait for the end of the headers
+    const QByteArray pending = socket->peek(MaxRequestSize);
+    if (!pending.contains("\r\n\r\n")) {
+        if (pending.size() >= MaxRequestSize) {
+            socket->abort();
+        }
+        return;
+    }
+    const QList<QByteArray> line = pending.left(pending.indexOf("\r\n")).split(' ');
+    socket->readAll();
+
+    QByteArray status = "200 OK";
+    QByteArray body;
+    if (line.size() < 2 || (line[0] != "GET" && line[0] != "HEAD")) {
+        status = "405 Method Not Allowed";
+    } else if (line[1] != "/metrics" && !line[1].startsWith("/metrics?")) {
+        status = "404 Not Found";
+    } else if (line[0] == "GET") {
+        body = render();
+    }
+    socket->write("HTTP/1.1 " + status + "\r\n");
+    socket->write("Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n");
+    socket->write("Content-Length: " + QByteArray::number(body.size()) + "\r\n");
+    socket->write("Connection: close\r\n\r\n");
+    socket->write(body);
+    socket->disconnectFromHost();
+}
+
+void MetricsServer::checkLag()
+{
+    const qint64 elapsed = m_lagClock.restart();
+    m_lastLag = qMax<qint64>(0, elapsed - LagInterval) / 1000.0;
+    m_lag.observe(m_lastLag);
+}
+
+QString MetricsServer::labels(const Channel *channel, const QString &device)
+{
+    // the default channel has no name of its own
+    const QString name = channel->name().isEmpty() ? u"default"_qs : channel->name();
+    const QString labels = u"channel=\"%1\""_qs.arg(name);
+    return device.isEmpty() ? labels : labels + u",device=\"%1\""_qs.arg(device);
+}
+
+void MetricsServer::watch(Channel *channel)
+{
+    // every channel shows up with zeros before its first refresh
+    const QString channelLabels = labels(channel);
+    m_refreshes.insert(channelLabels, m_refreshes.value(channelLabels));
+    m_refreshFailures.insert(channelLabels, m_refreshFailures.value(channelLabels));
+    connect(channel->twitch(), &TwitchManager::refreshed, this,
+            [this, channelLabels](bool success) {
+                m_refreshes[channelLabels]++;
+                if (!success) {
+                    m_refreshFailures[channelLabels]++;
+                }
+            });
+    const QString shock = labels(channel, u"shock"_qs);
+    const QString smoke = labels(channel, u"smoke"_qs);
+    connect(channel->shockCollar(), &ShockCollarManager::pinged, this,
+            [this, shock](const qint64 &micros, bool success) { ping(shock, micros, success); });
+    connect(channel->smokeMachine(), &SmokeMachineManager::pinged, this,
+            [this, smoke](const qint64 &micros, bool success) { ping(smoke, micros, success); });
+}
+
+void MetricsServer::ping(const QString &deviceLabels, const qint64 &micros, bool success)
+{
+    // failed pings mostly measure the timeout, keep them out of the rtt
+    if (success) {
+        m_pings[deviceLabels].observe(micros / 1e6);
+        m_lastPing[deviceLabels] = micros / 1e6;
+    }
+}
+
+QByteArray MetricsServer::render() const
+{
+    QString out;
+
+    header(out, u"chap_helix_requests_total"_qs, u"counter"_qs,
+           u"Helix requests answered, by endpoint, method and status (0 for no response)."_qs);
+    for (auto it = m_helixRequests.cbegin(); it != m_helixRequests.cend(); ++it) {
+        sample(out, u"chap_helix_requests_total"_qs, it.key(), it.value());
+    }
+    header(out, u"chap_helix_request_duration_seconds"_qs, u"histogram"_qs,
+           u"Time from sending a Helix request to its reply."_qs);
+    for (auto it = m_helixLatency.cbegin(); it != m_helixLatency.cend(); ++it) {
+        histogram(out, u"chap_helix_request_duration_seconds"_qs, it.key(), it->buckets,
+                  it->count, it->sum);
+    }
+    header(out, u"chap_helix_queued_requests"_qs, u"gauge"_qs,
+           u"Helix requests waiting in the scheduler."_qs);
+    sample(out, u"chap_helix_queued_requests"_qs, {}, m_core->scheduler()->queued());
+
+    const QList<Channel *> channels = m_core->channels();
+    header(out, u"chap_token_refreshes_total"_qs, u"counter"_qs, u"Token refreshes attempted."_qs);
+    for (auto it = m_refreshes.cbegin(); it != m_refreshes.cend(); ++it) {
+        sample(out, u"chap_token_refreshes_total"_qs, it.key(), it.value());
+    }
+    header(out, u"chap_token_refresh_failures_total"_qs, u"counter"_qs,
+           u"Token refreshes that didn't get usable tokens."_qs);
+    for (auto it = m_refreshFailures.cbegin(); it != m_refreshFailures.cend(); ++it) {
+        sample(out, u"chap_token_refresh_failures_total"_qs, it.key(), it.value());
+    }
+    header(out, u"chap_logged_in"_qs, u"gauge"_qs, u"Whether we hold a valid session."_qs);
+    for (const Channel *channel : channels) {
+        sample(out, u"chap_logged_in"_qs, labels(channel), channel->twitch()->loggedIn());
+    }
+    header(out, u"chap_eventsub_connected"_qs, u"gauge"_qs,
+           u"Whether the EventSub websocket is connected."_qs);
+    for (const Channel *channel : channels) {
+        sample(out, u"chap_eventsub_connected"_qs, labels(channel),
+               channel->twitch()->eventSub()->connected());
+    }
+
+    // channels sharing a device show the same queue, each under its own name
+    QList<std::pair<QString, ActionQueue *>> queues;
+    for (const Channel *channel : channels) {
+        queues.append({labels(channel, u"shock"_qs), channel->router()->shockQueue()});
+        queues.append({labels(channel, u"smoke"_qs), channel->router()->smokeQueue()});
+    }
+    header(out, u"chap_redemption_backlog"_qs, u"gauge"_qs,
+           u"Redemptions waiting for their device."_qs);
+    for (const auto &[queueLabels, queue] : queues) {
+        sample(out, u"chap_redemption_backlog"_qs, queueLabels, queue->depth());
+    }
+    header(out, u"chap_redemption_oldest_wait_seconds"_qs, u"gauge"_qs,
+           u"How long the oldest waiting redemption has waited."_qs);
+    for (const auto &[queueLabels, queue] : queues) {
+        sample(out, u"chap_redemption_oldest_wait_seconds"_qs, queueLabels,
+               queue->oldestWait() / 1000.0);
+    }
+
+    header(out, u"chap_device_online"_qs, u"gauge"_qs,
+           u"Whether the device answered its last ping."_qs);
+    for (const Channel *channel : channels) {
+        sample(out, u"chap_device_online"_qs, labels(channel, u"shock"_qs),
+               channel->shockCollar()->online());
+        sample(out, u"chap_device_online"_qs, labels(channel, u"smoke"_qs),
+               channel->smokeMachine()->online());
+    }
+    header(out, u"chap_device_ping_seconds"_qs, u"gauge"_qs,
+           u"Round trip of the last answered ping."_qs);
+    for (auto it = m_lastPing.cbegin(); it != m_lastPing.cend(); ++it) {
+        sample(out, u"chap_device_ping_seconds"_qs, it.key(), it.value());
+    }
+    header(out, u"chap_device_ping_duration_seconds"_qs, u"histogram"_qs,
+           u"Round trip of answered pings."_qs);
+    for (auto it = m_pings.cbegin(); it != m_pings.cend(); ++it) {
+        histogram(out, u"chap_device_ping_duration_seconds"_qs, it.key(), it->buckets, it->count,
+                  it->sum);
+    }
+
+    // device and stage for every channel, with the count of what's behind it
+    QList<std::pair<QString, QVariantMap>> stages;
+    for (const Channel *channel : channels) {
+        const QVariantMap stats = channel->latency()->stats();
+        for (auto device = stats.cbegin(); device != stats.cend(); ++device) {
+            const QVariantMap byStage = device->toMap();
+            for (auto stage = byStage.cbegin(); stage != byStage.cend(); ++stage) {
+                stages.append({labels(channel, device.key()) +
+                                   u",stage=\"%1\""_qs.arg(stage.key()),
+                               stage->toMap()});
+            }
+        }
+    }
+    header(out, u"chap_redemption_stage_seconds"_qs, u"summary"_qs,
+           u"Time redemptions spend in each stage over the last ten minutes."_qs);
+    for (const auto &[stageLabels, values] : stages) {
+        for (const QString &quantile : {u"p50"_qs, u"p95"_qs, u"p99"_qs}) {
+            sample(out, u"chap_redemption_stage_seconds"_qs,
+                   stageLabels + u",quantile=\"0.%1\""_qs.arg(quantile.mid(1)),
+                   values.value(quantile).toDouble() / 1000.0);
+        }
+    }
+    header(out, u"chap_redemption_stage_samples"_qs, u"gauge"_qs,
+           u"Redemptions behind each stage summary."_qs);
+    for (const auto &[stageLabels, values] : stages) {
+        sample(out, u"chap_redemption_stage_samples"_qs, stageLabels,
+               values.value(u"count"_qs).toDouble());
+    }
+
+    header(out, u"chap_event_loop_lag_seconds"_qs, u"gauge"_qs,
+           u"How late the last event loop check ran."_qs);
+    sample(out, u"chap_event_loop_lag_seconds"_qs, {}, m_lastLag);
+    header(out, u"chap_event_loop_lag_duration_seconds"_qs, u"histogram"_qs,
+           u"How late event loop checks ran."_qs);
+    histogram(out, u"chap_event_loop_lag_duration_seconds"_qs, {}, m_lag.buckets, m_lag.count,
+              m_lag.sum);
+
+    header(out, u"chap_log_dropped_lines_total"_qs, u"counter"_qs,
+           u"Log lines dropped because the writer fell behind."_qs);
+    sample(out, u"chap_log_dropped_lines_total"_qs, {}, AsyncLogger::dropped());
+
+    return out.toUtf8();
+}
@@ -0,0 +1,79 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include <vector>
+
+#include "core.h"
+
+/* Serves a prometheus text format /metrics page on localhost.
+ *
+ * Counts and times every helix request by endpoint, method, and status, token
+ * refreshes, the redemption backlog in front of each device, whether the
+ * devices are up and how long their pings take, and how late the event loop
+ * gets around to a timer. The per stage redemption latencies from each
+ * channel's LatencyTracker are passed through as summaries. Anything that
+ * belongs to a channel is labelled with it.
+ *
+ * Everything is tallied as it happens and only formatted when scraped, so an
+ * idle scraper costs nothing. Only loopback connections are accepted, this
+ * is for a scraper on the same box and not meant to be exposed.
+ */
+class MetricsServer : public QObject
+{
+    Q_OBJECT
+
+  public:
+    // upper bounds of the latency histogram buckets, seconds
+    inline const static std::vector<double> LatencyBuckets{0.005, 0.01, 0.025, 0.05, 0.1,
+                                                           0.25,  0.5,  1,     2.5,  5};
+    // how often the event loop is checked for lag, msecs
+    inline const static int LagInterval{100};
+    // requests bigger than this get the connection dropped, bytes
+    inline const static int MaxRequestSize{8 * 1024};
+
+    explicit MetricsServer(Core *core, QObject *parent = nullptr);
+
+    bool listen(const quint16 &port);
+    QByteArray render() const;
+
+  private slots:
+    void newConnection();
+    void checkLag();
+    void watch(Channel *channel);
+
+  private:
+    struct Histogram {
+        std::vector<quint64> buckets = std::vector<quint64>(LatencyBuckets.size(), 0);
+        quint64 count = 0;
+        double sum = 0;
+
+        void observe(const double &seconds);
+    };
+
+    Core *m_core;
+    QTcpServer *m_server;
+    QTimer *m_lagTimer;
+    QElapsedTimer m_lagClock;
+    // keyed by the rendered label set
+    QHash<QString, quint64> m_helixRequests;
+    QHash<QString, Histogram> m_helixLatency;
+    QHash<QString, quint64> m_refreshes;
+    QHash<QString, quint64> m_refreshFailures;
+    QHash<QString, Histogram> m_pings;
+    QHash<QString, double> m_lastPing;
+    Histogram m_lag;
+    double m_lastLag;
+
+    void readRequest(QTcpSocket *socket);
+    static QString labels(const Channel *channel, const QString &device = {});
+    void ping(const QString &deviceLabels, const qint64 &micros, bool success);
+};
+
+#endif // METRICSSERVER_H
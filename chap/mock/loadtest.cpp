@@ -0,0 +1,261 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QTimer>
+
+#include <algorithm>
+#include <vector>
+
+#include "../core.h"
+#include "../qtutils.h"
+#include "../sessionstore.h"
+#include "mockdeviceserver.h"
+#include "mockeventsubserver.h"
+#include "mockhelixserver.h"
+#include "mockloadgenerator.h"
+
+// End to end load test, the whole backend runs against the stand-ins in
+// this process so every stage is timed on the same clock:
+//
+//   injected   the load generator created the redemption and sent the event
+//   device     the device manager sent the request for it
+//   settled    the helix stand-in got the update marking it fulfilled
+//
+// The stand-ins share the event loop with the backend, their cost is part of
+// what gets measured, so treat the numbers as an upper bound.
+
+struct Timing {
+    qint64 injected = -1;
+    qint64 device = -1;
+    qint64 settled = -1;
+    bool canceled = false;
+};
+
+static QString percentiles(std::vector<qint64> &values)
+{
+    if (values.empty()) {
+        return u"n/a"_qs;
+    }
+    std::sort(values.begin(), values.end());
+    auto at = [&values](const double &p) {
+        const size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+        return values[qMin(index, values.size() - 1)] / 1000.0;
+    };
+    return u"p50 %1  p90 %2  p99 %3  max %4 ms"_qs.arg(at(0.5), 0, 'f', 2)
+        .arg(at(0.9), 0, 'f', 2)
+        .arg(at(0.99), 0, 'f', 2)
+        .arg(values.back() / 1000.0, 0, 'f', 2);
+}
+
+int main(int argc, char *argv[])
+{
+    qInstallMessageHandler(messageHandler);
+
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(u"chap-loadtest"_qs);
+    app.setOrganizationName(u"chap-loadtest"_qs);
+    // keeps the session, journal and reward cache away from the real ones
+    QStandardPaths::setTestModeEnabled(true);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        u"Measures redemption to device to fulfilled latency against local stand-ins."_qs);
+    parser.addHelpOption();
+    QCommandLineOption rateOption(u"rate"_qs, u"Inject <n> redemptions a second."_qs, u"n"_qs,
+                                  u"50"_qs);
+    QCommandLineOption secondsOption(u"seconds"_qs, u"Inject for <seconds>."_qs, u"seconds"_qs,
+                                     u"10"_qs);
+    QCommandLineOption drainOption(u"drain"_qs,
+                                   u"Wait up to <seconds> for the rest to settle afterwards."_qs,
+                                   u"seconds"_qs, u"30"_qs);
+    QCommandLineOption rewardOption(u"reward"_qs, u"Redeem the <shock|smoke> reward."_qs,
+                                    u"device"_qs, u"shock"_qs);
+    QCommandLineOption policyOption(u"policy"_qs,
+                                    u"Device queue <coalesce|sequential|extend> policy."_qs,
+                                    u"policy"_qs, u"coalesce"_qs);
+    QCommandLineOption gapOption(u"gap"_qs, u"Device queue minimum gap in <ms>."_qs, u"ms"_qs,
+                                 u"0"_qs);
+    QCommandLineOption depthOption(u"depth"_qs, u"Device queue max depth."_qs, u"n"_qs,
+                                   u"100000"_qs);
+    QCommandLineOption latencyOption(u"latency"_qs, u"Hold Helix responses for <ms>."_qs, u"ms"_qs,
+                                     u"0"_qs);
+    QCommandLineOption jitterOption(u"jitter"_qs, u"Add up to <ms> of random latency."_qs,
+                                    u"ms"_qs, u"0"_qs);
+    QCommandLineOption errorRateOption(u"error-rate"_qs,
+                                       u"Fail a <fraction> of Helix requests with a 503."_qs,
+                                       u"fraction"_qs, u"0"_qs);
+    QCommandLineOption throttleRateOption(u"throttle-rate"_qs,
+                                          u"Answer a <fraction> of Helix requests with a 429."_qs,
+                                          u"fraction"_qs, u"0"_qs);
+    QCommandLineOption rateLimitOption(u"rate-limit"_qs,
+                                       u"Allow <n> Helix requests a minute, 0 for no limit."_qs,
+                                       u"n"_qs, u"800"_qs);
+    parser.addOptions({rateOption, secondsOption, drainOption, rewardOption, policyOption,
+                       gapOption, depthOption, latencyOption, jitterOption, errorRateOption,
+                       throttleRateOption, rateLimitOption});
+    parser.process(app);
+
+    const double rate = parser.value(rateOption).toDouble();
+    const int seconds = parser.value(secondsOption).toInt();
+    const bool smoke = parser.value(rewardOption) == u"smoke"_qs;
+    const QString policy = parser.value(policyOption);
+
+    // start clean, anything left from a previous run would skew it
+    const QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir(dataPath).removeRecursively();
+
+    MockHelixServer helix;
+    helix.setLatency(parser.value(latencyOption).toInt(), parser.value(jitterOption).toInt());
+    helix.setErrorRate(parser.value(errorRateOption).toDouble());
+    helix.setThrottleRate(parser.value(throttleRateOption).toDouble());
+    helix.setRateLimit(parser.value(rateLimitOption).toInt());
+    MockEventSubServer eventSub;
+    MockDeviceServer devices;
+    if (!helix.listen(0) || !eventSub.listen(0) || !devices.listen(0)) {
+        return 1;
+    }
+
+    // a session the stand-in will validate, so there is no login to do
+    {
+        SessionStore session(dataPath + u"/session.json"_qs);
+        session.setTokens(u"loadtest"_qs, u"loadtest"_qs,
+                          QDateTime::currentDateTimeUtc().addSecs(4 * 60 * 60));
+        session.setUser(MockHelixServer::UserLogin, MockHelixServer::UserId);
+        session.flush();
+    }
+
+    Core *core = new Core(&app);
+    TwitchManager *twitch = core->twitch();
+    twitch->useTwitchStandIn(helix.url());
+    twitch->useEventSubStandIn(eventSub.url());
+    QObject::connect(twitch, &TwitchManager::validated, twitch, &TwitchManager::getRewards);
+    const QString deviceAddress = u"127.0.0.1:%1"_qs.arg(devices.url().port());
+    core->shockCollar()->setIpAddress(deviceAddress);
+    core->smokeMachine()->setIpAddress(deviceAddress);
+
+    ActionQueue *queue = smoke ? core->router()->smokeQueue() : core->router()->shockQueue();
+    if (policy == u"sequential"_qs) {
+        queue->setPolicy(ActionQueue::Sequential);
+    } else if (policy == u"extend"_qs) {
+        queue->setPolicy(ActionQueue::ExtendDuration);
+    } else {
+        queue->setPolicy(ActionQueue::Coalesce);
+    }
+    queue->setMinGap(parser.value(gapOption).toInt());
+    queue->setMaxDepth(parser.value(depthOption).toInt());
+    // the stand-in device doesn't actually run, don't wait on it
+    core->smokeMachine()->setDuration(1);
+    if (smoke) {
+        queue->setMaxDuration(1);
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+    QHash<QString, Timing> timings;
+    MockLoadGenerator load(&helix, &eventSub);
+    load.setRate(rate);
+    QObject::connect(&load, &MockLoadGenerator::redemptionInjected, &app,
+                     [&](const QString &id) { timings[id].injected = clock.nsecsElapsed(); });
+    auto dispatched = [&](const QList<QString> &ids) {
+        const qint64 now = clock.nsecsElapsed();
+        for (const QString &id : ids) {
+            auto iter = timings.find(id);
+            if (iter != timings.end() && iter->device < 0) {
+                iter->device = now;
+            }
+        }
+    };
+    QObject::connect(core->shockCollar(), &ShockCollarManager::dispatched, &app, dispatched);
+    QObject::connect(core->smokeMachine(), &SmokeMachineManager::dispatched, &app, dispatched);
+
+    qint64 firstSettled = -1;
+    qint64 lastSettled = -1;
+    int settled = 0;
+    QObject::connect(&helix, &MockHelixServer::redemptionUpdated, &app,
+                     [&](const QString &id, const QString &status) {
+                         auto iter = timings.find(id);
+                         if (iter == timings.end() || iter->settled >= 0) {
+                             return;
+                         }
+                         iter->settled = clock.nsecsElapsed();
+                         iter->canceled = status != u"FULFILLED"_qs;
+                         lastSettled = iter->settled;
+                         if (firstSettled < 0) {
+                             firstSettled = iter->settled;
+                         }
+                         settled++;
+                     });
+
+    auto report = [&]() {
+        std::vector<qint64> toDevice;
+        std::vector<qint64> toSettled;
+        std::vector<qint64> deviceToSettled;
+        int fulfilled = 0;
+        int canceled = 0;
+        for (const Timing &timing : qAsConst(timings)) {
+            if (timing.device >= 0) {
+                toDevice.push_back((timing.device - timing.injected) / 1000);
+            }
+            if (timing.settled < 0) {
+                continue;
+            }
+            if (timing.canceled) {
+                canceled++;
+                continue;
+            }
+            fulfilled++;
+            toSettled.push_back((timing.settled - timing.injected) / 1000);
+            if (timing.device >= 0) {
+                deviceToSettled.push_back((timing.settled - timing.device) / 1000);
+            }
+        }
+        const double span = (lastSettled - firstSettled) / 1e9;
+        QTextStream out(stdout);
+        out << "policy " << policy << ", " << rate << "/s for " << seconds << "s\n";
+        out << "injected   " << load.injected() << "\n";
+        out << "fulfilled  " << fulfilled << "\n";
+        out << "canceled   " << canceled << "\n";
+        out << "unsettled  " << (timings.size() - settled) << "\n";
+        out << "throughput " << QString::number(span > 0 ? fulfilled / span : 0, 'f', 1)
+            << " fulfilled/s\n";
+        out << "redemption -> device    " << percentiles(toDevice) << "\n";
+        out << "device -> fulfilled     " << percentiles(deviceToSettled) << "\n";
+        out << "redemption -> fulfilled " << percentiles(toSettled) << "\n";
+        out << "helix requests " << helix.requests() << ", 429s " << helix.throttled()
+            << ", errors " << helix.errors() << "\n";
+        out << "device calls   " << (devices.shocks() + devices.activations()) << "\n";
+    };
+
+    // go once we're validated, have the rewards and the device is up
+    QTimer ready;
+    QObject::connect(&ready, &QTimer::timeout, &app, [&]() {
+        const QVariant reward = smoke ? twitch->smokeReward() : twitch->shockReward();
+        if (!twitch->loggedIn() || !reward.isValid() || !queue->online() ||
+            !twitch->eventSub()->connected()) {
+            return;
+        }
+        ready.stop();
+        load.setRewardId(reward.value<Reward>().id);
+        load.start();
+        QTimer::singleShot(seconds * 1000, &load, [&]() {
+            load.stop();
+            const qint64 drainUntil = clock.elapsed() + parser.value(drainOption).toInt() * 1000;
+            QTimer *drain = new QTimer(&app);
+            QObject::connect(drain, &QTimer::timeout, &app, [&, drainUntil]() {
+                if (settled < timings.size() && clock.elapsed() < drainUntil) {
+                    return;
+                }
+                report();
+                app.quit();
+            });
+            drain->start(100);
+        });
+    });
+    ready.start(100);
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, core, [&]() { core->save(); });
+
+    return app.exec();
+}
@@ -0,0 +1,110 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTimer>
+
+#include "../qtutils.h"
+#include "mockdeviceserver.h"
+#include "mockeventsubserver.h"
+#include "mockhelixserver.h"
+#include "mockloadgenerator.h"
+
+int main(int argc, char *argv[])
+{
+    qInstallMessageHandler(messageHandler);
+
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(u"chap-mock"_qs);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(u"Local stand-in for the Twitch services chap uses."_qs);
+    parser.addHelpOption();
+    QCommandLineOption portOption(u"port"_qs, u"Listen for EventSub clients on <port>."_qs,
+                                  u"port"_qs, u"8080"_qs);
+    QCommandLineOption keepaliveOption(u"keepalive"_qs, u"Keepalive timeout in <seconds>."_qs,
+                                       u"seconds"_qs, u"10"_qs);
+    QCommandLineOption intervalOption(u"interval"_qs, u"Send a redemption every <ms>."_qs,
+                                      u"ms"_qs, u"5000"_qs);
+    QCommandLineOption rewardIdOption(u"reward-id"_qs, u"Reward <id> to redeem."_qs, u"id"_qs,
+                                      u"mock-reward"_qs);
+    QCommandLineOption rewardTitleOption(u"reward-title"_qs, u"Reward <title> to redeem."_qs,
+                                         u"title"_qs, u"Shock The Streamer"_qs);
+    QCommandLineOption reconnectOption(u"reconnect-after"_qs,
+                                       u"Request a session_reconnect after <seconds>."_qs,
+                                       u"seconds"_qs, u"0"_qs);
+    QCommandLineOption silenceOption(u"silence-after"_qs,
+                                     u"Stop sending keepalives after <seconds>."_qs,
+                                     u"seconds"_qs, u"0"_qs);
+    QCommandLineOption helixPortOption(u"helix-port"_qs,
+                                       u"Serve the OAuth and Helix endpoints on <port>."_qs,
+                                       u"port"_qs, u"8081"_qs);
+    QCommandLineOption devicePortOption(
+        u"device-port"_qs, u"Stand in for the shock collar and smoke machine on <port>."_qs,
+        u"port"_qs, u"8082"_qs);
+    QCommandLineOption rateOption(u"rate"_qs,
+                                  u"Redeem the reward titled --reward-title <n> times a second."_qs,
+                                  u"n"_qs, u"0"_qs);
+    QCommandLineOption latencyOption(u"latency"_qs, u"Hold Helix responses for <ms>."_qs, u"ms"_qs,
+                                     u"0"_qs);
+    QCommandLineOption jitterOption(u"jitter"_qs, u"Add up to <ms> of random latency."_qs,
+                                    u"ms"_qs, u"0"_qs);
+    QCommandLineOption errorRateOption(u"error-rate"_qs,
+                                       u"Fail a <fraction> of Helix requests with a 503."_qs,
+                                       u"fraction"_qs, u"0"_qs);
+    QCommandLineOption throttleRateOption(u"throttle-rate"_qs,
+                                          u"Answer a <fraction> of Helix requests with a 429."_qs,
+                                          u"fraction"_qs, u"0"_qs);
+    QCommandLineOption rateLimitOption(u"rate-limit"_qs,
+                                       u"Allow <n> Helix requests a minute, 0 for no limit."_qs,
+                                       u"n"_qs, u"800"_qs);
+    parser.addOptions({portOption, keepaliveOption, intervalOption, rewardIdOption,
+                       rewardTitleOption, reconnectOption, silenceOption, helixPortOption,
+                       devicePortOption, rateOption, latencyOption, jitterOption, errorRateOption,
+                       throttleRateOption, rateLimitOption});
+    parser.process(app);
+
+    MockEventSubServer eventSub;
+    eventSub.setKeepaliveSeconds(parser.value(keepaliveOption).toInt());
+    if (!eventSub.listen(parser.value(portOption).toUShort())) {
+        return 1;
+    }
+
+    MockHelixServer helix;
+    helix.setLatency(parser.value(latencyOption).toInt(), parser.value(jitterOption).toInt());
+    helix.setErrorRate(parser.value(errorRateOption).toDouble());
+    helix.setThrottleRate(parser.value(throttleRateOption).toDouble());
+    helix.setRateLimit(parser.value(rateLimitOption).toInt());
+    if (!helix.listen(parser.value(helixPortOption).toUShort())) {
+        return 1;
+    }
+    MockDeviceServer devices;
+    if (!devices.listen(parser.value(devicePortOption).toUShort())) {
+        return 1;
+    }
+
+    MockLoadGenerator load(&helix, &eventSub);
+    load.setRewardId(helix.reward(parser.value(rewardTitleOption)).value(u"id"_qs).toString());
+    load.setRate(parser.value(rateOption).toDouble());
+    load.start();
+
+    const QString rewardId = parser.value(rewardIdOption);
+    const QString rewardTitle = parser.value(rewardTitleOption);
+    QTimer redemptionTimer;
+    QObject::connect(&redemptionTimer, &QTimer::timeout, &eventSub,
+                     [&]() { eventSub.sendRedemption(rewardId, rewardTitle); });
+    const int interval = parser.value(intervalOption).toInt();
+    if (interval > 0) {
+        redemptionTimer.start(interval);
+    }
+
+    const int reconnectAfter = parser.value(reconnectOption).toInt();
+    if (reconnectAfter > 0) {
+        QTimer::singleShot(reconnectAfter * 1000, &eventSub, &MockEventSubServer::requestReconnect);
+    }
+    const int silenceAfter = parser.value(silenceOption).toInt();
+    if (silenceAfter > 0) {
+        QTimer::singleShot(silenceAfter * 1000, &eventSub,
+                           [&]() { eventSub.setKeepalivesEnabled(false); });
+    }
+
+    return app.exec();
+}
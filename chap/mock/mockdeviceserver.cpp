@@ -0,0 +1,29 @@
+#include "mockdeviceserver.h"
+
+#include <QUrlQuery>
+
+MockDeviceServer::MockDeviceServer(QObject *parent)
+    : MockHttpServer{u"Device"_qs, parent}
+    , m_shocks(0)
+    , m_activations(0)
+{
+}
+
+MockHttpServer::Response MockDeviceServer::handle(const Request &request)
+{
+    const QString path = request.url.path();
+    if (path == u"/shock"_qs && request.verb == "POST") {
+        m_shocks++;
+        emit shocked();
+        return Response{200, "shocked", "text/plain", {}};
+    }
+    if (path == u"/activate"_qs && request.verb == "POST") {
+        m_activations++;
+        emit activated(QUrlQuery(request.url).queryItemValue(u"duration"_qs).toInt());
+        return Response{200, "activated", "text/plain", {}};
+    }
+    if (path == u"/"_qs) {
+        return Response{200, "ok", "text/plain", {}};
+    }
+    return Response{404, QByteArray(), "text/plain", {}};
+}
@@ -0,0 +1,30 @@
+#ifndef MOCKDEVICESERVER_H
+#define MOCKDEVICESERVER_H
+
+#include "mockhttpserver.h"
+
+// Stand-in for the shock collar and smoke machine, answers their ping,
+// shock and activate endpoints so both managers can point at one port.
+class MockDeviceServer : public MockHttpServer
+{
+    Q_OBJECT
+
+  public:
+    explicit MockDeviceServer(QObject *parent = nullptr);
+
+    quint64 shocks() const { return m_shocks; }
+    quint64 activations() const { return m_activations; }
+
+  signals:
+    void shocked();
+    void activated(int duration);
+
+  protected:
+    Response handle(const Request &request) override;
+
+  private:
+    quint64 m_shocks;
+    quint64 m_activations;
+};
+
+#endif // MOCKDEVICESERVER_H
@@ -0,0 +1,165 @@
+#include "mockeventsubserver.h"
+
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QRandomGenerator>
+#include <QUrlQuery>
+#include <QUuid>
+
+static QString timestamp() { return QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs); }
+
+static QString uuid() { return QUuid::createUuid().toString(QUuid::WithoutBraces); }
+
+MockEventSubServer::MockEventSubServer(QObject *parent)
+    : QObject{parent}
+    , m_server(new QWebSocketServer(u"chap-mock"_qs, QWebSocketServer::NonSecureMode, this))
+    , m_keepaliveTimer(new QTimer(this))
+    , m_sessions()
+    , m_keepaliveSeconds(10)
+    , m_keepalivesEnabled(true)
+{
+    connect(m_server, &QWebSocketServer::newConnection, this, &MockEventSubServer::newConnection);
+    connect(m_keepaliveTimer, &QTimer::timeout, this, &MockEventSubServer::sendKeepalives);
+}
+
+bool MockEventSubServer::listen(const quint16 &port)
+{
+    if (!m_server->listen(QHostAddress::LocalHost, port)) {
+        qWarning() << "EventSub stand-in failed to listen:" << m_server->errorString();
+        return false;
+    }
+    // twitch sends keepalives a little inside the advertised timeout
+    m_keepaliveTimer->start(qMax(1, m_keepaliveSeconds - 1) * 1000);
+    qInfo() << "EventSub stand-in listening on:" << url();
+    return true;
+}
+
+QUrl MockEventSubServer::url() const
+{
+    return QUrl(u"ws://127.0.0.1:%1/ws"_qs.arg(m_server->serverPort()));
+}
+
+void MockEventSubServer::newConnection()
+{
+    QWebSocket *socket = m_server->nextPendingConnection();
+    connect(socket, &QWebSocket::disconnected, this, &MockEventSubServer::socketDisconnected);
+
+    // clients following a session_reconnect keep their session
+    const QUrlQuery query(socket->requestUrl());
+    QString sessionId = query.queryItemValue(u"reconnect"_qs);
+    if (sessionId.isEmpty() || !m_sessions.contains(sessionId)) {
+        sessionId = uuid();
+        qInfo() << "New EventSub session:" << sessionId;
+    } else {
+        qInfo() << "EventSub session handed over:" << sessionId;
+    }
+    m_sessions.insert(sessionId, socket);
+    socket->setProperty("sessionId", sessionId);
+
+    QJsonObject session{
+        {u"id"_qs, sessionId},
+        {u"status"_qs, u"connected"_qs},
+        {u"keepalive_timeout_seconds"_qs, m_keepaliveSeconds},
+        {u"reconnect_url"_qs, QJsonValue::Null},
+        {u"connected_at"_qs, timestamp()},
+    };
+    send(socket, u"session_welcome"_qs, {{u"session"_qs, session}});
+}
+
+void MockEventSubServer::socketDisconnected()
+{
+    QWebSocket *socket = qobject_cast<QWebSocket *>(QObject::sender());
+    const QString sessionId = socket->property("sessionId").toString();
+    if (m_sessions.value(sessionId) == socket) {
+        qInfo() << "EventSub session closed:" << sessionId;
+        m_sessions.remove(sessionId);
+    }
+    socket->deleteLater();
+}
+
+void MockEventSubServer::sendKeepalives()
+{
+    if (!m_keepalivesEnabled) {
+        return;
+    }
+    for (QWebSocket *socket : qAsConst(m_sessions)) {
+        send(socket, u"session_keepalive"_qs, {});
+    }
+}
+
+void MockEventSubServer::sendRedemption(const QString &rewardId, const QString &rewardTitle)
+{
+    const quint32 user = QRandomGenerator::global()->bounded(1000u, 9999u);
+    sendRedemptionEvent({
+        {u"id"_qs, uuid()},
+        {u"broadcaster_user_id"_qs, u"12345"_qs},
+        {u"broadcaster_user_login"_qs, u"mockbroadcaster"_qs},
+        {u"broadcaster_user_name"_qs, u"MockBroadcaster"_qs},
+        {u"user_id"_qs, QString::number(user)},
+        {u"user_login"_qs, u"viewer%1"_qs.arg(user)},
+        {u"user_name"_qs, u"Viewer%1"_qs.arg(user)},
+        {u"user_input"_qs, u""_qs},
+        {u"status"_qs, u"unfulfilled"_qs},
+        {u"reward"_qs, QJsonObject{{u"id"_qs, rewardId},
+                                   {u"title"_qs, rewardTitle},
+                                   {u"cost"_qs, 100},
+                                   {u"prompt"_qs, u""_qs}}},
+        {u"redeemed_at"_qs, timestamp()},
+    });
+}
+
+void MockEventSubServer::sendRedemptionEvent(const QJsonObject &event)
+{
+    for (auto iter = m_sessions.cbegin(); iter != m_sessions.cend(); ++iter) {
+        QJsonObject subscription{
+            {u"id"_qs, uuid()},
+            {u"type"_qs, u"channel.channel_points_custom_reward_redemption.add"_qs},
+            {u"version"_qs, u"1"_qs},
+            {u"status"_qs, u"enabled"_qs},
+            {u"cost"_qs, 0},
+            {u"condition"_qs, QJsonObject{{u"broadcaster_user_id"_qs, u"12345"_qs}}},
+            {u"transport"_qs, QJsonObject{{u"method"_qs, u"websocket"_qs},
+                                          {u"session_id"_qs, iter.key()}}},
+            {u"created_at"_qs, timestamp()},
+        };
+        send(iter.value(), u"notification"_qs,
+             {{u"subscription"_qs, subscription}, {u"event"_qs, event}},
+             subscription.value(u"type"_qs).toString());
+    }
+}
+
+void MockEventSubServer::requestReconnect()
+{
+    for (auto iter = m_sessions.cbegin(); iter != m_sessions.cend(); ++iter) {
+        QUrlQuery query;
+        query.addQueryItem(u"reconnect"_qs, iter.key());
+        QUrl reconnectUrl(url());
+        reconnectUrl.setQuery(query);
+        QJsonObject session{
+            {u"id"_qs, iter.key()},
+            {u"status"_qs, u"reconnecting"_qs},
+            {u"keepalive_timeout_seconds"_qs, QJsonValue::Null},
+            {u"reconnect_url"_qs, reconnectUrl.toString()},
+            {u"connected_at"_qs, timestamp()},
+        };
+        qInfo() << "Requesting EventSub reconnect:" << iter.key();
+        send(iter.value(), u"session_reconnect"_qs, {{u"session"_qs, session}});
+    }
+}
+
+void MockEventSubServer::send(QWebSocket *socket, const QString &type, const QJsonObject &payload,
+                              const QString &subscriptionType)
+{
+    QJsonObject metadata{
+        {u"message_id"_qs, uuid()},
+        {u"message_type"_qs, type},
+        {u"message_timestamp"_qs, timestamp()},
+    };
+    if (!subscriptionType.isEmpty()) {
+        metadata.insert(u"subscription_type"_qs, subscriptionType);
+        metadata.insert(u"subscription_version"_qs, u"1"_qs);
+    }
+    QJsonObject message{{u"metadata"_qs, metadata}, {u"payload"_qs, payload}};
+    const QByteArray data = QJsonDocument(message).toJson(QJsonDocument::Compact);
+    socket->sendTextMessage(QString::fromUtf8(data));
+}
@@ -0,0 +1,49 @@
+#ifndef MOCKEVENTSUBSERVER_H
+#define MOCKEVENTSUBSERVER_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QTimer>
+#include <QWebSocket>
+#include <QWebSocketServer>
+
+// Stand-in for wss://eventsub.wss.twitch.tv/ws, it welcomes every client,
+// sends keepalives and pushes redemption notifications without needing any
+// subscriptions to be created first.
+class MockEventSubServer : public QObject
+{
+    Q_OBJECT
+
+  public:
+    explicit MockEventSubServer(QObject *parent = nullptr);
+
+    bool listen(const quint16 &port);
+    QUrl url() const;
+    void setKeepaliveSeconds(const int &seconds) { m_keepaliveSeconds = seconds; }
+
+  public slots:
+    void sendRedemption(const QString &rewardId, const QString &rewardTitle);
+    // announces a redemption that was created elsewhere, the helix stand-in
+    void sendRedemptionEvent(const QJsonObject &event);
+    void requestReconnect();
+    void setKeepalivesEnabled(const bool &enabled) { m_keepalivesEnabled = enabled; }
+
+  private slots:
+    void newConnection();
+    void socketDisconnected();
+    void sendKeepalives();
+
+  private:
+    QWebSocketServer *m_server;
+    QTimer *m_keepaliveTimer;
+    // latest socket for each session, a handover replaces the socket
+    QHash<QString, QWebSocket *> m_sessions;
+    int m_keepaliveSeconds;
+    bool m_keepalivesEnabled;
+
+    void send(QWebSocket *socket, const QString &type, const QJsonObject &payload,
+              const QString &subscriptionType = QString());
+};
+
+#endif // MOCKEVENTSUBSERVER_H
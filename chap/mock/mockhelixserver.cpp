@@ -0,0 +1,312 @@
+#include "mockhelixserver.h"
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QRandomGenerator>
+#include <QUrlQuery>
+#include <QUuid>
+
+static QString timestamp() { return QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs); }
+
+static QString uuid() { return QUuid::createUuid().toString(QUuid::WithoutBraces); }
+
+// the ui sends some booleans as strings, helix takes either
+static bool toBool(const QJsonValue &value)
+{
+    return value.isString() ? value.toString() == u"true"_qs : value.toBool();
+}
+
+MockHelixServer::MockHelixServer(QObject *parent)
+    : MockHttpServer{u"Helix"_qs, parent}
+    , m_rewards()
+    , m_redemptions()
+    , m_redemptionIndex()
+    , m_unfulfilled(0)
+{
+    addReward(u"Shock The Streamer"_qs, 100);
+    addReward(u"Hotbox The Streamer"_qs, 1);
+}
+
+QJsonObject MockHelixServer::addReward(const QString &title, const int &cost)
+{
+    QJsonObject reward{
+        {u"broadcaster_id"_qs, UserId},
+        {u"broadcaster_login"_qs, UserLogin},
+        {u"broadcaster_name"_qs, UserLogin},
+        {u"id"_qs, uuid()},
+        {u"title"_qs, title},
+        {u"prompt"_qs, u""_qs},
+        {u"cost"_qs, cost},
+        {u"is_enabled"_qs, true},
+        {u"is_paused"_qs, false},
+        {u"should_redemptions_skip_request_queue"_qs, false},
+        {u"global_cooldown_setting"_qs,
+         QJsonObject{{u"is_enabled"_qs, false}, {u"global_cooldown_seconds"_qs, 0}}},
+    };
+    m_rewards.append(reward);
+    return reward;
+}
+
+QJsonObject MockHelixServer::reward(const QString &title) const
+{
+    for (const QJsonObject &reward : m_rewards) {
+        if (reward.value(u"title"_qs).toString() == title) {
+            return reward;
+        }
+    }
+    return QJsonObject();
+}
+
+QJsonObject MockHelixServer::addRedemption(const QString &rewardId)
+{
+    QJsonObject reward;
+    for (const QJsonObject &r : qAsConst(m_rewards)) {
+        if (r.value(u"id"_qs).toString() == rewardId) {
+            reward = r;
+            break;
+        }
+    }
+    const quint32 user = QRandomGenerator::global()->bounded(1000u, 9999u);
+    const QString redeemedAt = timestamp();
+    const QJsonObject rewardRef{
+        {u"id"_qs, rewardId},
+        {u"title"_qs, reward.value(u"title"_qs)},
+        {u"prompt"_qs, reward.value(u"prompt"_qs)},
+        {u"cost"_qs, reward.value(u"cost"_qs)},
+    };
+    QJsonObject redemption{
+        {u"broadcaster_id"_qs, UserId},
+        {u"broadcaster_login"_qs, UserLogin},
+        {u"broadcaster_name"_qs, UserLogin},
+        {u"id"_qs, uuid()},
+        {u"user_id"_qs, QString::number(user)},
+        {u"user_login"_qs, u"viewer%1"_qs.arg(user)},
+        {u"user_name"_qs, u"Viewer%1"_qs.arg(user)},
+        {u"user_input"_qs, u""_qs},
+        {u"status"_qs, u"UNFULFILLED"_qs},
+        {u"redeemed_at"_qs, redeemedAt},
+        {u"reward"_qs, rewardRef},
+    };
+    m_redemptionIndex.insert(redemption.value(u"id"_qs).toString(), m_redemptions.size());
+    m_redemptions.append(redemption);
+    m_unfulfilled++;
+
+    // eventsub names the broadcaster fields differently and lowercases status
+    return {
+        {u"id"_qs, redemption.value(u"id"_qs)},
+        {u"broadcaster_user_id"_qs, UserId},
+        {u"broadcaster_user_login"_qs, UserLogin},
+        {u"broadcaster_user_name"_qs, UserLogin},
+        {u"user_id"_qs, redemption.value(u"user_id"_qs)},
+        {u"user_login"_qs, redemption.value(u"user_login"_qs)},
+        {u"user_name"_qs, redemption.value(u"user_name"_qs)},
+        {u"user_input"_qs, u""_qs},
+        {u"status"_qs, u"unfulfilled"_qs},
+        {u"reward"_qs, rewardRef},
+        {u"redeemed_at"_qs, redeemedAt},
+    };
+}
+
+MockHttpServer::Response MockHelixServer::handle(const Request &request)
+{
+    const QString path = request.url.path();
+    if (path == u"/oauth2/authorize"_qs) {
+        return authorize(request);
+    }
+    if (path == u"/oauth2/token"_qs) {
+        return token(request);
+    }
+    if (path == u"/oauth2/validate"_qs) {
+        return validate(request);
+    }
+    if (path == u"/oauth2/revoke"_qs) {
+        return Response{200, QByteArray(), "text/plain", {}};
+    }
+    if (!request.headers.value("authorization").startsWith("Bearer ")) {
+        return json(401, {{u"error"_qs, u"Unauthorized"_qs},
+                          {u"status"_qs, 401},
+                          {u"message"_qs, u"Missing token"_qs}});
+    }
+    if (path == u"/helix/channel_points/custom_rewards"_qs) {
+        return rewards(request);
+    }
+    if (path == u"/helix/channel_points/custom_rewards/redemptions"_qs) {
+        return request.verb == "PATCH" ? updateRedemptions(request) : redemptions(request);
+    }
+    if (path == u"/helix/eventsub/subscriptions"_qs) {
+        return subscribe(request);
+    }
+    return json(404, {{u"error"_qs, u"Not Found"_qs}, {u"status"_qs, 404}});
+}
+
+MockHttpServer::Response MockHelixServer::authorize(const Request &request)
+{
+    // skip the consent page, straight back to the app with a code
+    const QUrlQuery query(request.url);
+    QUrlQuery callback;
+    callback.addQueryItem(u"code"_qs, uuid());
+    callback.addQueryItem(u"scope"_qs, query.queryItemValue(u"scope"_qs));
+    callback.addQueryItem(u"state"_qs, query.queryItemValue(u"state"_qs));
+    QUrl redirect(query.queryItemValue(u"redirect_uri"_qs, QUrl::FullyDecoded));
+    redirect.setQuery(callback);
+    Response response{302, QByteArray(), "text/plain", {}};
+    response.headers.append({"Location", redirect.toEncoded()});
+    return response;
+}
+
+MockHttpServer::Response MockHelixServer::token(const Request &)
+{
+    return json(200, {
+                         {u"access_token"_qs, uuid()},
+                         {u"refresh_token"_qs, uuid()},
+                         {u"expires_in"_qs, 4 * 60 * 60},
+                         {u"scope"_qs, QJsonArray{u"moderator:manage:announcements"_qs,
+                                                  u"channel:manage:redemptions"_qs}},
+                         {u"token_type"_qs, u"bearer"_qs},
+                     });
+}
+
+MockHttpServer::Response MockHelixServer::validate(const Request &)
+{
+    return json(200, {
+                         {u"client_id"_qs, u"mock-client"_qs},
+                         {u"login"_qs, UserLogin},
+                         {u"scopes"_qs, QJsonArray{u"moderator:manage:announcements"_qs,
+                                                   u"channel:manage:redemptions"_qs}},
+                         {u"user_id"_qs, UserId},
+                         {u"expires_in"_qs, 4 * 60 * 60},
+                     });
+}
+
+MockHttpServer::Response MockHelixServer::rewards(const Request &request)
+{
+    const QUrlQuery query(request.url);
+    if (request.verb == "GET") {
+        const QList<QString> ids = query.allQueryItemValues(u"id"_qs);
+        QJsonArray data;
+        for (const QJsonObject &reward : qAsConst(m_rewards)) {
+            if (ids.isEmpty() || ids.contains(reward.value(u"id"_qs).toString())) {
+                data.append(reward);
+            }
+        }
+        return json(200, {{u"data"_qs, data}});
+    }
+
+    const QJsonObject body = QJsonDocument::fromJson(request.body).object();
+    QJsonObject reward;
+    qsizetype index = -1;
+    if (request.verb == "POST") {
+        reward = addReward(body.value(u"title"_qs).toString(), body.value(u"cost"_qs).toInt());
+        index = m_rewards.size() - 1;
+    } else {
+        const QString id = query.queryItemValue(u"id"_qs);
+        for (qsizetype i = 0; i < m_rewards.size(); i++) {
+            if (m_rewards[i].value(u"id"_qs).toString() == id) {
+                index = i;
+                reward = m_rewards[i];
+                break;
+            }
+        }
+        if (index < 0) {
+            return json(404, {{u"error"_qs, u"Not Found"_qs}, {u"status"_qs, 404}});
+        }
+    }
+    for (auto iter = body.constBegin(); iter != body.constEnd(); ++iter) {
+        if (iter.key() == u"is_global_cooldown_enabled"_qs) {
+            QJsonObject cooldown = reward.value(u"global_cooldown_setting"_qs).toObject();
+            cooldown.insert(u"is_enabled"_qs, toBool(iter.value()));
+            reward.insert(u"global_cooldown_setting"_qs, cooldown);
+        } else if (iter.key() == u"global_cooldown_seconds"_qs) {
+            QJsonObject cooldown = reward.value(u"global_cooldown_setting"_qs).toObject();
+            cooldown.insert(u"global_cooldown_seconds"_qs, iter.value().toInt());
+            reward.insert(u"global_cooldown_setting"_qs, cooldown);
+        } else if (iter.key().startsWith(u"is_"_qs) || iter.key().startsWith(u"should_"_qs)) {
+            reward.insert(iter.key(), toBool(iter.value()));
+        } else if (iter.key() != u"id"_qs) {
+            reward.insert(iter.key(), iter.value());
+        }
+    }
+    m_rewards[index] = reward;
+    return json(200, {{u"data"_qs, QJsonArray{reward}}});
+}
+
+MockHttpServer::Response MockHelixServer::redemptions(const Request &request)
+{
+    const QUrlQuery query(request.url);
+    const QString rewardId = query.queryItemValue(u"reward_id"_qs);
+    const QString status = query.queryItemValue(u"status"_qs);
+    const bool newest = query.queryItemValue(u"sort"_qs) == u"NEWEST"_qs;
+    const int first = qBound(1, query.queryItemValue(u"first"_qs).toInt(), 50);
+    // the cursor is just how many matches to skip
+    const int after = query.queryItemValue(u"after"_qs).toInt();
+
+    QJsonArray data;
+    int matched = 0;
+    bool more = false;
+    const qsizetype count = m_redemptions.size();
+    for (qsizetype i = 0; i < count; i++) {
+        const QJsonObject &redemption = m_redemptions[newest ? count - 1 - i : i];
+        if (redemption.value(u"status"_qs).toString() != status ||
+            redemption.value(u"reward"_qs).toObject().value(u"id"_qs).toString() != rewardId) {
+            continue;
+        }
+        if (matched++ < after) {
+            continue;
+        }
+        if (data.size() == first) {
+            more = true;
+            break;
+        }
+        data.append(redemption);
+    }
+    QJsonObject pagination;
+    if (more) {
+        pagination.insert(u"cursor"_qs, QString::number(after + first));
+    }
+    return json(200, {{u"data"_qs, data}, {u"pagination"_qs, pagination}});
+}
+
+MockHttpServer::Response MockHelixServer::updateRedemptions(const Request &request)
+{
+    const QUrlQuery query(request.url);
+    const QString status =
+        QJsonDocument::fromJson(request.body).object().value(u"status"_qs).toString();
+    if (status != u"FULFILLED"_qs && status != u"CANCELED"_qs) {
+        return json(400, {{u"error"_qs, u"Bad Request"_qs}, {u"status"_qs, 400}});
+    }
+
+    QJsonArray data;
+    for (const QString &id : query.allQueryItemValues(u"id"_qs)) {
+        const qsizetype index = m_redemptionIndex.value(id, -1);
+        if (index < 0) {
+            continue;
+        }
+        QJsonObject &redemption = m_redemptions[index];
+        // only unfulfilled redemptions can be updated, same as helix
+        if (redemption.value(u"status"_qs).toString() != u"UNFULFILLED"_qs) {
+            continue;
+        }
+        redemption.insert(u"status"_qs, status);
+        m_unfulfilled--;
+        data.append(redemption);
+        emit redemptionUpdated(id, status);
+    }
+    if (data.isEmpty()) {
+        return json(404, {{u"error"_qs, u"Not Found"_qs}, {u"status"_qs, 404}});
+    }
+    return json(200, {{u"data"_qs, data}});
+}
+
+MockHttpServer::Response MockHelixServer::subscribe(const Request &request)
+{
+    QJsonObject subscription = QJsonDocument::fromJson(request.body).object();
+    subscription.insert(u"id"_qs, uuid());
+    subscription.insert(u"status"_qs, u"enabled"_qs);
+    subscription.insert(u"cost"_qs, 0);
+    subscription.insert(u"created_at"_qs, timestamp());
+    return json(202, {{u"data"_qs, QJsonArray{subscription}},
+                      {u"total"_qs, 1},
+                      {u"total_cost"_qs, 0},
+                      {u"max_total_cost"_qs, 10}});
+}
@@ -0,0 +1,52 @@
+#ifndef MOCKHELIXSERVER_H
+#define MOCKHELIXSERVER_H
+
+#include <QJsonObject>
+#include <QList>
+
+#include "mockhttpserver.h"
+
+// Stand-in for id.twitch.tv and api.twitch.tv, the oauth endpoints plus the
+// custom reward, redemption and eventsub subscription endpoints TwitchManager
+// uses. Any token is accepted and there is a single broadcaster that starts
+// out with the shock and smoke rewards. Redemptions are added from outside,
+// the load generator adds them and announces them over eventsub.
+class MockHelixServer : public MockHttpServer
+{
+    Q_OBJECT
+
+  public:
+    inline const static QString UserId{u"12345"_qs};
+    inline const static QString UserLogin{u"mockbroadcaster"_qs};
+
+    explicit MockHelixServer(QObject *parent = nullptr);
+
+    QJsonObject addReward(const QString &title, const int &cost);
+    QJsonObject reward(const QString &title) const;
+    // a new unfulfilled redemption, eventsub shaped so it can be sent as is
+    QJsonObject addRedemption(const QString &rewardId);
+    int unfulfilled() const { return m_unfulfilled; }
+
+  signals:
+    void redemptionUpdated(const QString &id, const QString &status);
+
+  protected:
+    Response handle(const Request &request) override;
+
+  private:
+    QList<QJsonObject> m_rewards;
+    // oldest first, newest at the back
+    QList<QJsonObject> m_redemptions;
+    QHash<QString, qsizetype> m_redemptionIndex;
+    int m_unfulfilled;
+
+    Response authorize(const Request &request);
+    Response token(const Request &request);
+    Response validate(const Request &request);
+    Response rewards(const Request &request);
+    Response redemptions(const Request &request);
+    Response updateRedemptions(const Request &request);
+    Response subscribe(const Request &request);
+};
+
+#endif // MOCKHELIXSERVER_H
@@ -0,0 +1,204 @@
+#include "mockhttpserver.h"
+
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QRandomGenerator>
+#include <QTimer>
+
+#include "../qtutils.h"
+
+static QByteArray reason(const int &status)
+{
+    switch (status) {
+    case 200:
+        return "OK";
+    case 202:
+        return "Accepted";
+    case 204:
+        return "No Content";
+    case 302:
+        return "Found";
+    case 400:
+        return "Bad Request";
+    case 401:
+        return "Unauthorized";
+    case 404:
+        return "Not Found";
+    case 429:
+        return "Too Many Requests";
+    case 503:
+        return "Service Unavailable";
+    default:
+        return "Unknown";
+    }
+}
+
+MockHttpServer::MockHttpServer(const QString &name, QObject *parent)
+    : QObject{parent}
+    , m_name(name)
+    , m_server(new QTcpServer(this))
+    , m_latency(0)
+    , m_jitter(0)
+    , m_errorRate(0)
+    , m_throttleRate(0)
+    , m_rateLimit(0)
+    , m_remaining(0)
+    , m_resetAt(0)
+    , m_requests(0)
+    , m_errors(0)
+    , m_throttled(0)
+{
+    connect(m_server, &QTcpServer::newConnection, this, &MockHttpServer::newConnection);
+}
+
+bool MockHttpServer::listen(const quint16 &port)
+{
+    if (!m_server->listen(QHostAddress::LocalHost, port)) {
+        qWarning() << m_name << "stand-in failed to listen:" << m_server->errorString();
+        return false;
+    }
+    qInfo() << m_name << "stand-in listening on:" << url();
+    return true;
+}
+
+QUrl MockHttpServer::url() const
+{
+    return QUrl(u"http://127.0.0.1:%1"_qs.arg(m_server->serverPort()));
+}
+
+void MockHttpServer::setLatency(const int &msecs, const int &jitter)
+{
+    m_latency = qMax(0, msecs);
+    m_jitter = qMax(0, jitter);
+}
+
+void MockHttpServer::setRateLimit(const int &limit)
+{
+    m_rateLimit = qMax(0, limit);
+    m_remaining = m_rateLimit;
+    m_resetAt = 0;
+}
+
+MockHttpServer::Response MockHttpServer::json(const int &status, const QJsonObject &object)
+{
+    Response response;
+    response.status = status;
+    response.body = QJsonDocument(object).toJson(QJsonDocument::Compact);
+    return response;
+}
+
+void MockHttpServer::newConnection()
+{
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QTcpSocket::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, this, &MockHttpServer::readyRead);
+    }
+}
+
+void MockHttpServer::readyRead()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(QObject::sender());
+    Request request;
+    while (parse(socket, request)) {
+        const Response response = respond(request);
+        int delay = m_latency;
+        if (m_jitter > 0) {
+            delay += QRandomGenerator::global()->bounded(m_jitter + 1);
+        }
+        if (delay > 0) {
+            QTimer::singleShot(delay, socket,
+                               [this, socket, response]() { write(socket, response); });
+        } else {
+            write(socket, response);
+        }
+    }
+}
+
+bool MockHttpServer::parse(QTcpSocket *socket, Request &request)
+{
+    // whatever arrived so far is kept on the socket until a request is whole
+    QByteArray buffer = socket->property("buffer").toByteArray() + socket->readAll();
+    const qsizetype headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        socket->setProperty("buffer", buffer);
+        return false;
+    }
+
+    const QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+    request = Request();
+    request.verb = requestLine.value(0);
+    request.url = QUrl::fromEncoded(requestLine.value(1));
+    for (qsizetype i = 1; i < lines.size(); i++) {
+        const qsizetype colon = lines[i].indexOf(':');
+        if (colon > 0) {
+            request.headers.insert(lines[i].left(colon).trimmed().toLower(),
+                                   lines[i].mid(colon + 1).trimmed());
+        }
+    }
+    const qsizetype length = request.headers.value("content-length").toLongLong();
+    const qsizetype bodyStart = headerEnd + 4;
+    if (buffer.size() - bodyStart < length) {
+        socket->setProperty("buffer", buffer);
+        return false;
+    }
+    request.body = buffer.mid(bodyStart, length);
+    socket->setProperty("buffer", buffer.mid(bodyStart + length));
+    return true;
+}
+
+MockHttpServer::Response MockHttpServer::respond(const Request &request)
+{
+    m_requests++;
+    Response response;
+    bool throttled = false;
+    if (m_rateLimit > 0) {
+        // the whole bucket refills a minute after it was first drawn from
+        const qint64 now = QDateTime::currentSecsSinceEpoch();
+        if (now >= m_resetAt) {
+            m_remaining = m_rateLimit;
+            m_resetAt = now + 60;
+        }
+        throttled = m_remaining <= 0;
+        if (!throttled) {
+            m_remaining--;
+        }
+    }
+    if (!throttled && m_throttleRate > 0) {
+        throttled = QRandomGenerator::global()->generateDouble() < m_throttleRate;
+    }
+
+    if (throttled) {
+        m_throttled++;
+        response = json(429, {{u"error"_qs, u"Too Many Requests"_qs},
+                              {u"status"_qs, 429},
+                              {u"message"_qs, u"Rate limit exceeded"_qs}});
+    } else if (m_errorRate > 0 && QRandomGenerator::global()->generateDouble() < m_errorRate) {
+        m_errors++;
+        response = json(503, {{u"error"_qs, u"Service Unavailable"_qs},
+                              {u"status"_qs, 503},
+                              {u"message"_qs, u"Injected error"_qs}});
+    } else {
+        response = handle(request);
+    }
+
+    if (m_rateLimit > 0) {
+        response.headers.append({"Ratelimit-Limit", QByteArray::number(m_rateLimit)});
+        response.headers.append({"Ratelimit-Remaining", QByteArray::number(qMax(0, m_remaining))});
+        response.headers.append({"Ratelimit-Reset", QByteArray::number(m_resetAt)});
+    }
+    return response;
+}
+
+void MockHttpServer::write(QTcpSocket *socket, const Response &response)
+{
+    QByteArray out = "HTTP/1.1 " + QByteArray::number(response.status) + ' ' +
+                     reason(response.status) + "\r\n";
+    out += "Content-Type: " + response.contentType + "\r\n";
+    out += "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n";
+    for (const auto &header : response.headers) {
+        out += header.first + ": " + header.second + "\r\n";
+    }
+    out += "\r\n" + response.body;
+    socket->write(out);
+}
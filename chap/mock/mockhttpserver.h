@@ -0,0 +1,79 @@
+#ifndef MOCKHTTPSERVER_H
+#define MOCKHTTPSERVER_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUrl>
+
+// Bare bones HTTP/1.1 server for the stand-ins, keep-alive and
+// Content-Length bodies only, which is all QNetworkAccessManager needs.
+//
+// Every response can be held back for a latency plus random jitter, a share
+// of requests can be failed with a 503, and requests beyond a per-minute
+// limit get a 429 with the same Ratelimit-* headers twitch sends. On top of
+// that a share of requests can be throttled no matter what is left.
+class MockHttpServer : public QObject
+{
+    Q_OBJECT
+
+  public:
+    struct Request {
+        QByteArray verb;
+        QUrl url;
+        QHash<QByteArray, QByteArray> headers;
+        QByteArray body;
+    };
+
+    struct Response {
+        int status = 200;
+        QByteArray body;
+        QByteArray contentType = "application/json";
+        QList<QPair<QByteArray, QByteArray>> headers;
+    };
+
+    explicit MockHttpServer(const QString &name, QObject *parent = nullptr);
+
+    bool listen(const quint16 &port);
+    QUrl url() const;
+
+    void setLatency(const int &msecs, const int &jitter = 0);
+    void setErrorRate(const double &rate) { m_errorRate = rate; }
+    void setThrottleRate(const double &rate) { m_throttleRate = rate; }
+    // requests allowed per minute, zero for no limit
+    void setRateLimit(const int &limit);
+
+    quint64 requests() const { return m_requests; }
+    quint64 errors() const { return m_errors; }
+    quint64 throttled() const { return m_throttled; }
+
+  protected:
+    virtual Response handle(const Request &request) = 0;
+    static Response json(const int &status, const QJsonObject &object);
+
+  private slots:
+    void newConnection();
+    void readyRead();
+
+  private:
+    QString m_name;
+    QTcpServer *m_server;
+    int m_latency;
+    int m_jitter;
+    double m_errorRate;
+    double m_throttleRate;
+    int m_rateLimit;
+    int m_remaining;
+    qint64 m_resetAt;
+    quint64 m_requests;
+    quint64 m_errors;
+    quint64 m_throttled;
+
+    bool parse(QTcpSocket *socket, Request &request);
+    Response respond(const Request &request);
+    void write(QTcpSocket *socket, const Response &response);
+};
+
+#endif // MOCKHTTPSERVER_H
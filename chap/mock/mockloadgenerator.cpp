@@ -0,0 +1,42 @@
+#include "mockloadgenerator.h"
+
+MockLoadGenerator::MockLoadGenerator(MockHelixServer *helix, MockEventSubServer *eventSub,
+                                     QObject *parent)
+    : QObject{parent}
+    , m_helix(helix)
+    , m_eventSub(eventSub)
+    , m_timer(new QTimer(this))
+    , m_clock()
+    , m_rewardId()
+    , m_rate(1)
+    , m_injected(0)
+{
+    connect(m_timer, &QTimer::timeout, this, &MockLoadGenerator::tick);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    m_timer->setInterval(TickInterval);
+}
+
+void MockLoadGenerator::start()
+{
+    if (m_rate <= 0 || m_rewardId.isEmpty()) {
+        return;
+    }
+    qInfo() << "Redeeming" << m_rewardId << m_rate << "times a second";
+    m_injected = 0;
+    m_clock.start();
+    m_timer->start();
+    tick();
+}
+
+void MockLoadGenerator::stop() { m_timer->stop(); }
+
+void MockLoadGenerator::tick()
+{
+    const quint64 due = static_cast<quint64>(m_clock.elapsed() * m_rate / 1000.0) + 1;
+    while (m_injected < due) {
+        const QJsonObject event = m_helix->addRedemption(m_rewardId);
+        m_injected++;
+        emit redemptionInjected(event.value(u"id"_qs).toString());
+        m_eventSub->sendRedemptionEvent(event);
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef MOCKLOADGENERATOR_H
+#define MOCKLOADGENERATOR_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+#include "mockeventsubserver.h"
+#include "mockhelixserver.h"
+
+// Redeems a reward at a steady rate, each redemption goes into the helix
+// stand-in so polls and updates see it and is announced over eventsub. The
+// timer ticks every few msecs and catches up to the rate, so a high rate
+// doesn't depend on the timer keeping up one redemption at a time.
+class MockLoadGenerator : public QObject
+{
+    Q_OBJECT
+
+  public:
+    // how often we check how far behind the rate we are, msecs
+    inline const static int TickInterval{5};
+
+    explicit MockLoadGenerator(MockHelixServer *helix, MockEventSubServer *eventSub,
+                               QObject *parent = nullptr);
+
+    void setRewardId(const QString &rewardId) { m_rewardId = rewardId; }
+    // redemptions per second
+    void setRate(const double &rate) { m_rate = rate; }
+    quint64 injected() const { return m_injected; }
+
+  signals:
+    void redemptionInjected(const QString &id);
+
+  public slots:
+    void start();
+    void stop();
+
+  private slots:
+    void tick();
+
+  private:
+    MockHelixServer *m_helix;
+    MockEventSubServer *m_eventSub;
+    QTimer *m_timer;
+    QElapsedTimer m_clock;
+    QString m_rewardId;
+    double m_rate;
+    quint64 m_injected;
+};
+
+#endif // MOCKLOADGENERATOR_H
@@ -36,56 +36,37 @@ ApplicationWindow {
 
     }
 
-    readonly property var shockReward: twitch.rewards.find(
-                                           x => x.title === "Shock The Streamer")
-    readonly property var smokeReward: twitch.rewards.find(
-                                           x => x.title === "Hotbox The Streamer")
+    readonly property var shockReward: twitch.shockReward
+    readonly property var smokeReward: twitch.smokeReward
     readonly property bool hasAllRewards: !!shockReward && !!smokeReward
 
-    function getRedemptions() {
+    // cached rewards are there before we even load, don't wait on the timer
+    // to catch up on anything redeemed while we were closed
+    Component.onCompleted: {
         if (hasAllRewards) {
-            var data = {
-                "reward_id": shockReward.id,
-                "status": "UNFULFILLED"
-            }
-            twitch.getRedemptions(data)
-            data = {
-                "reward_id": smokeReward.id,
-                "status": "UNFULFILLED"
-            }
-            twitch.getRedemptions(data)
-        } else if (twitch.rewards.length === 0) {
-            twitch.getRewards()
+            getRedemptions()
+        }
+    }
+    onHasAllRewardsChanged: {
+        if (hasAllRewards) {
+            getRedemptions()
         }
     }
 
-    function processRedemptions(redemptions) {
-        if (redemptions.length > 0 || !hasAllRewards) {
-            var shouldShock = false
-            var shouldSmoke = false
-            redemptions.map(x => {
-                                if (x.reward.id === shockReward.id) {
-                                    shouldShock = true
-                                }
-                                if (x.reward.id === smokeReward.id) {
-                                    shouldSmoke = true
-                                }
-                                twitch.updateRedemption(x.reward.id, x.id,
-                                                        "FULFILLED")
-                            })
-            if (shouldShock) {
-                shockCollar.shock()
-            }
-            if (shouldSmoke) {
-                smokeMachine.activate()
-            }
+    function getRedemptions() {
+        if (hasAllRewards) {
+            twitch.syncRedemptions(shockReward.id)
+            twitch.syncRedemptions(smokeReward.id)
+        } else if (twitch.rewards.count === 0) {
+            twitch.getRewards()
         }
     }
 
+    // eventsub pushes redemptions to us, so only poll as a fallback
     Timer {
         running: true
         repeat: true
-        interval: 10 * 1000
+        interval: twitch.eventSub.connected ? 60 * 1000 : 10 * 1000
 
         onTriggered: getRedemptions()
     }
@@ -97,12 +78,14 @@ ApplicationWindow {
             twitch.getRewards()
         }
 
-        function onRewardsChanged() {
+        function onGotRewards() {
             getRedemptions()
         }
 
-        function onGotRedemptions(redemptions) {
-            processRedemptions(redemptions)
+        function onRedemptionUpdated(rewardId, id, status, success) {
+            if (!success) {
+                console.warn(`Failed to mark redemption ${id} as ${status}`)
+            }
         }
     }
 
@@ -154,35 +137,35 @@ ApplicationWindow {
 
             Button {
                 text: qsTr("Login")
-                enabled: !twitch.loading && !twitch.loggedIn
+                enabled: !twitch.authorizing && !twitch.loggedIn
 
                 onClicked: twitch.login()
             }
 
             Button {
                 text: qsTr("Logout")
-                enabled: !twitch.loading && twitch.loggedIn
+                enabled: !twitch.authorizing && twitch.loggedIn
 
                 onClicked: twitch.logout()
             }
 
             Button {
                 text: qsTr("Refresh")
-                enabled: !twitch.loading && twitch.loggedIn
+                enabled: !twitch.authorizing && twitch.loggedIn
 
                 onClicked: twitch.refresh()
             }
 
             Button {
                 text: qsTr("Get Rewards")
-                enabled: !twitch.loading && twitch.loggedIn
+                enabled: !twitch.fetchingRewards && twitch.loggedIn
 
                 onClicked: twitch.getRewards()
             }
 
             Button {
                 text: qsTr("Get Redemptions")
-                enabled: !twitch.loading && twitch.loggedIn && hasAllRewards
+                enabled: !twitch.fetchingRedemptions && twitch.loggedIn && hasAllRewards
 
                 onClicked: getRedemptions()
             }
@@ -199,7 +182,7 @@ ApplicationWindow {
 
             Button {
                 text: qsTr("Create Reward")
-                enabled: !twitch.loading && twitch.loggedIn && !shockReward
+                enabled: !twitch.updatingRewards && twitch.loggedIn && !shockReward
 
                 onClicked: {
                     var data = {
@@ -217,8 +200,8 @@ ApplicationWindow {
 
             Button {
                 text: qsTr("Enable Reward")
-                visible: !!shockReward && shockReward.is_paused
-                enabled: !twitch.loading && twitch.loggedIn && !!shockReward
+                visible: !!shockReward && shockReward.isPaused
+                enabled: !twitch.updatingRewards && twitch.loggedIn && !!shockReward
 
                 onClicked: {
                     var data = {
@@ -235,8 +218,8 @@ ApplicationWindow {
 
             Button {
                 text: qsTr("Pause Reward")
-                visible: !!shockReward && !shockReward.is_paused
-                enabled: !twitch.loading && twitch.loggedIn && !!shockReward
+                visible: !!shockReward && !shockReward.isPaused
+                enabled: !twitch.updatingRewards && twitch.loggedIn && !!shockReward
 
                 onClicked: {
                     var data = {
@@ -287,7 +270,7 @@ ApplicationWindow {
 
             Button {
                 text: qsTr("Create Reward")
-                enabled: !twitch.loading && twitch.loggedIn && !smokeReward
+                enabled: !twitch.updatingRewards && twitch.loggedIn && !smokeReward
 
                 onClicked: {
                     var data = {
@@ -305,8 +288,8 @@ ApplicationWindow {
 
             Button {
                 text: qsTr("Enable Reward")
-                visible: !!smokeReward && smokeReward.is_paused
-                enabled: !twitch.loading && twitch.loggedIn && !!smokeReward
+                visible: !!smokeReward && smokeReward.isPaused
+                enabled: !twitch.updatingRewards && twitch.loggedIn && !!smokeReward
 
                 onClicked: {
                     var data = {
@@ -323,8 +306,8 @@ ApplicationWindow {
 
             Button {
                 text: qsTr("Pause Reward")
-                visible: !!smokeReward && !smokeReward.is_paused
-                enabled: !twitch.loading && twitch.loggedIn && !!smokeReward
+                visible: !!smokeReward && !smokeReward.isPaused
+                enabled: !twitch.updatingRewards && twitch.loggedIn && !!smokeReward
 
                 onClicked: {
                     var data = {
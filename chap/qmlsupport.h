@@ -0,0 +1,16 @@
+#ifndef QMLSUPPORT_H
+#define QMLSUPPORT_H
+
+// headless builds leave out QtQml, the registration macros turn into no-ops
+// and we pull in what <QtQml> would have brought along with it
+#ifdef CHAP_HEADLESS
+#include <QtCore>
+#include <QtNetwork>
+#define QML_ELEMENT
+#define QML_UNCREATABLE(REASON)
+#define QML_VALUE_TYPE(NAME)
+#else
+#include <QtQml>
+#endif
+
+#endif // QMLSUPPORT_H
@@ -1,12 +1,23 @@
 #ifndef QTUTILS_H
 #define QTUTILS_H
 
+#include <QFileDevice>
 #include <QObject>
 #include <QtGlobal>
 
-// Custom message handler for Qt logging
+// Custom message handler for Qt logging, writes on the calling thread so the
+// apps use AsyncLogger and this is left for tools and whatever logs at exit
 void messageHandler(QtMsgType type, const QMessageLogContext &, const QString &msg);
 
+// Replace the file at path with data, readers see either the old or new file
+bool writeFileAtomic(const QString &path, const QByteArray &data);
+
+// Flush an open file all the way to disk, not just to the OS
+bool syncToDisk(QFileDevice &file);
+
+// Microseconds on a monotonic clock shared by the whole process
+qint64 steadyMicros();
+
 // Helper to clear a collection of QObject pointers
 template <typename Container> inline void qDeleteAllLater(Container &c)
 {
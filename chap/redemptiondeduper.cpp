@@ -0,0 +1,61 @@
+#include "redemptiondeduper.h"
+
+RedemptionDeduper::RedemptionDeduper(const int &capacity, const qint64 &ttl)
+    : m_ttl(ttl)
+    , m_clock()
+    , m_ring(qMax(1, capacity))
+    , m_head(0)
+    , m_count(0)
+    , m_ids()
+{
+    m_clock.start();
+    m_ids.reserve(qMax(1, capacity));
+}
+
+bool RedemptionDeduper::insert(const QString &id)
+{
+    const qint64 now = m_clock.elapsed();
+    expire(now);
+    if (m_ids.contains(id)) {
+        return false;
+    }
+    if (m_count == static_cast<int>(m_ring.size())) {
+        dropOldest();
+    }
+    Entry &entry = m_ring[(m_head + m_count) % m_ring.size()];
+    entry.id = id;
+    entry.seenAt = now;
+    m_count++;
+    m_ids.insert(id);
+    return true;
+}
+
+bool RedemptionDeduper::contains(const QString &id)
+{
+    expire(m_clock.elapsed());
+    return m_ids.contains(id);
+}
+
+void RedemptionDeduper::clear()
+{
+    while (m_count > 0) {
+        dropOldest();
+    }
+}
+
+void RedemptionDeduper::expire(const qint64 &now)
+{
+    // entries go in oldest first, so we only ever look at the head
+    while (m_count > 0 && now - m_ring[m_head].seenAt > m_ttl) {
+        dropOldest();
+    }
+}
+
+void RedemptionDeduper::dropOldest()
+{
+    Entry &entry = m_ring[m_head];
+    m_ids.remove(entry.id);
+    entry.id.clear();
+    m_head = (m_head + 1) % m_ring.size();
+    m_count--;
+}
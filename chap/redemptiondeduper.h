@@ -0,0 +1,54 @@
+#ifndef REDEMPTIONDEDUPER_H
+#define REDEMPTIONDEDUPER_H
+
+#include <QElapsedTimer>
+#include <QSet>
+#include <QString>
+
+#include <vector>
+
+/* Remembers redemption ids we have already handed out.
+ *
+ * Polls overlap with eventsub and with each other, and a redemption stays
+ * unfulfilled on twitch until our update lands, so the same id can show up
+ * several times. Ids are kept in a fixed size ring and forgotten once they
+ * are older than the ttl or pushed out by newer ones, so a flood can't grow
+ * it past capacity.
+ */
+class RedemptionDeduper
+{
+  public:
+    // plenty for a flood, a few hundred KB at most
+    inline const static int DefaultCapacity{4096};
+    // long enough for a fulfillment update to land and the next poll to
+    // stop returning the redemption, msecs
+    inline const static qint64 DefaultTtl{10 * 60 * 1000};
+
+    explicit RedemptionDeduper(const int &capacity = DefaultCapacity,
+                               const qint64 &ttl = DefaultTtl);
+
+    // true the first time an id is seen within the ttl, false for repeats
+    bool insert(const QString &id);
+    bool contains(const QString &id);
+    int size() const { return m_count; }
+    void clear();
+
+  private:
+    struct Entry {
+        QString id;
+        qint64 seenAt = 0;
+    };
+
+    qint64 m_ttl;
+    QElapsedTimer m_clock;
+    std::vector<Entry> m_ring;
+    // index of the oldest entry
+    int m_head;
+    int m_count;
+    QSet<QString> m_ids;
+
+    void expire(const qint64 &now);
+    void dropOldest();
+};
+
+#endif // REDEMPTIONDEDUPER_H
@@ -0,0 +1,183 @@
+#include "redemptionjournal.h"
+
+#include <QDateTime>
+#include <QMetaEnum>
+
+#include "qtutils.h"
+
+RedemptionJournal::RedemptionJournal(const QString &path, QObject *parent)
+    : QObject{parent}
+    , m_path(path)
+    , m_commitTimer(new QTimer(this))
+    , m_compactTimer(new QTimer(this))
+    , m_writer(new QThreadPool(this))
+    , m_file(new QFile(path))
+    , m_entries()
+    , m_pending()
+    , m_pendingCount(0)
+    , m_lines(0)
+{
+    m_writer->setMaxThreadCount(1);
+
+    connect(m_commitTimer, &QTimer::timeout, this, &RedemptionJournal::commit);
+    m_commitTimer->setSingleShot(true);
+    m_commitTimer->setInterval(GroupCommitWindow);
+
+    connect(m_compactTimer, &QTimer::timeout, this, &RedemptionJournal::compact);
+    m_compactTimer->setInterval(CompactInterval);
+    m_compactTimer->start();
+}
+
+RedemptionJournal::~RedemptionJournal()
+{
+    flush();
+    delete m_file;
+}
+
+QHash<QString, RedemptionJournal::Entry> RedemptionJournal::load()
+{
+    m_writer->waitForDone();
+    m_entries.clear();
+    m_lines = 0;
+    QFile file(m_path);
+    if (file.open(QIODevice::ReadOnly)) {
+        const QMetaEnum states = QMetaEnum::fromType<State>();
+        while (!file.atEnd()) {
+            // a torn last line from a crash just gets skipped
+            const QByteArray data = file.readLine();
+            const QList<QByteArray> fields = data.trimmed().split('\t');
+            if (!data.endsWith('\n') || fields.size() != 4) {
+                continue;
+            }
+            bool ok = false;
+            const int state = states.keyToValue(fields.at(1).constData(), &ok);
+            if (!ok) {
+                continue;
+            }
+            Entry &entry = m_entries[QString::fromUtf8(fields.at(3))];
+            entry.id = QString::fromUtf8(fields.at(3));
+            entry.rewardId = QString::fromUtf8(fields.at(2));
+            entry.state = qMax(entry.state, static_cast<State>(state));
+            entry.changedAt = fields.at(0).toLongLong();
+            m_lines++;
+        }
+        qInfo() << "Loaded redemption journal:" << m_entries.size() << "redemptions";
+    }
+    // start from a clean journal so torn lines don't stick around
+    compact();
+    return m_entries;
+}
+
+RedemptionJournal::State RedemptionJournal::state(const QString &id) const
+{
+    return m_entries.value(id).state;
+}
+
+void RedemptionJournal::record(const QString &rewardId, const QString &id, const State &state)
+{
+    Entry &entry = m_entries[id];
+    if (!entry.id.isEmpty() && entry.state >= state) {
+        return;
+    }
+    entry.id = id;
+    if (!rewardId.isEmpty()) {
+        entry.rewardId = rewardId;
+    }
+    entry.state = state;
+    entry.changedAt = QDateTime::currentMSecsSinceEpoch();
+    m_pending.append(line(entry));
+    m_pendingCount++;
+    if (m_pendingCount >= GroupCommitSize) {
+        commit();
+    } else if (!m_commitTimer->isActive()) {
+        m_commitTimer->start();
+    }
+}
+
+void RedemptionJournal::record(const QList<QString> &ids, const State &state)
+{
+    // a shared device reports other channels' redemptions too, only the
+    // ones claimed here are ours to follow
+    for (const QString &id : ids) {
+        const auto entry = m_entries.constFind(id);
+        if (entry != m_entries.cend()) {
+            record(entry->rewardId, id, state);
+        }
+    }
+}
+
+void RedemptionJournal::dispatched(const QList<QString> &ids) { record(ids, Dispatched); }
+
+void RedemptionJournal::acked(const QList<QString> &ids, bool success)
+{
+    // a failed device call stays dispatched, we can't know if it went off
+    if (success) {
+        record(ids, Acked);
+    }
+}
+
+void RedemptionJournal::commit()
+{
+    m_commitTimer->stop();
+    if (m_pending.isEmpty()) {
+        return;
+    }
+    const QByteArray data = m_pending;
+    m_lines += m_pendingCount;
+    m_pending.clear();
+    m_pendingCount = 0;
+    QFile *file = m_file;
+    m_writer->start([file, data]() {
+        if (!file->isOpen() && !file->open(QIODevice::WriteOnly | QIODevice::Append)) {
+            qWarning() << "Failed to open redemption journal:" << file->fileName();
+            return;
+        }
+        if (file->write(data) != data.size() || !syncToDisk(*file)) {
+            qWarning() << "Failed to write redemption journal:" << file->errorString();
+        }
+    });
+}
+
+void RedemptionJournal::compact()
+{
+    // anything already recorded has to be in the snapshot, not after it
+    commit();
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QByteArray data;
+    int lines = 0;
+    for (auto iter = m_entries.begin(); iter != m_entries.end();) {
+        const qint64 keep = iter->state >= Fulfilled ? KeepFinished : KeepUnfinished;
+        if (iter->changedAt < now - keep) {
+            iter = m_entries.erase(iter);
+            continue;
+        }
+        data.append(line(iter.value()));
+        lines++;
+        ++iter;
+    }
+    qDebug() << "Compacting redemption journal from" << m_lines << "to" << lines << "lines";
+    m_lines = lines;
+
+    QFile *file = m_file;
+    const QString path = m_path;
+    m_writer->start([file, path, data]() {
+        file->close();
+        if (!writeFileAtomic(path, data)) {
+            qWarning() << "Failed to compact redemption journal:" << path;
+        }
+    });
+}
+
+void RedemptionJournal::flush()
+{
+    commit();
+    m_writer->waitForDone();
+}
+
+QByteArray RedemptionJournal::line(const Entry &entry)
+{
+    const char *state = QMetaEnum::fromType<State>().valueToKey(entry.state);
+    return QByteArray::number(entry.changedAt) + '\t' + state + '\t' + entry.rewardId.toUtf8() +
+           '\t' + entry.id.toUtf8() + '\n';
+}
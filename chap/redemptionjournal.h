@@ -0,0 +1,86 @@
+#ifndef REDEMPTIONJOURNAL_H
+#define REDEMPTIONJOURNAL_H
+
+#include <QFile>
+#include <QHash>
+#include <QObject>
+#include <QThreadPool>
+#include <QTimer>
+
+/* Append-only record of where every redemption got to.
+ *
+ * Each state change is a line in the journal, lines are buffered for a few
+ * msecs and written plus fsync'd as a group so a flood costs one sync per
+ * batch instead of one per redemption. On startup the journal is read back
+ * so we can pick up every redemption that hadn't been fulfilled yet, and
+ * every so often it is rewritten with only what is still worth keeping.
+ */
+class RedemptionJournal : public QObject
+{
+    Q_OBJECT
+
+  public:
+    // in order, a redemption only ever moves forward
+    enum State {
+        Seen,
+        Dispatched,
+        Acked,
+        Fulfilled,
+        Canceled,
+    };
+    Q_ENUM(State)
+
+    struct Entry {
+        QString id;
+        QString rewardId;
+        State state = Seen;
+        // msecs since epoch of the last change
+        qint64 changedAt = 0;
+    };
+
+    // longest a state change waits to be synced, msecs
+    inline const static int GroupCommitWindow{20};
+    // a batch this big is synced right away
+    inline const static int GroupCommitSize{256};
+    // how often the journal gets rewritten, msecs
+    inline const static int CompactInterval{10 * 60 * 1000};
+    // finished redemptions are kept this long so a restart still knows them
+    inline const static qint64 KeepFinished{60 * 60 * 1000};
+    // unfinished ones are given up on after this long, a shock a day late
+    // is no use to anyone and the viewer can ask for a refund
+    inline const static qint64 KeepUnfinished{24 * 60 * 60 * 1000};
+
+    explicit RedemptionJournal(const QString &path, QObject *parent = nullptr);
+    ~RedemptionJournal();
+
+    // reads the journal back, every redemption it knows of by id
+    QHash<QString, Entry> load();
+    State state(const QString &id) const;
+    bool contains(const QString &id) const { return m_entries.contains(id); }
+
+  public slots:
+    void record(const QString &rewardId, const QString &id, const State &state);
+    void record(const QList<QString> &ids, const State &state);
+    void dispatched(const QList<QString> &ids);
+    void acked(const QList<QString> &ids, bool success);
+    void commit();
+    void compact();
+    void flush();
+
+  private:
+    QString m_path;
+    QTimer *m_commitTimer;
+    QTimer *m_compactTimer;
+    // single thread so commits and compaction land in order
+    QThreadPool *m_writer;
+    // only ever touched from the writer thread
+    QFile *m_file;
+    QHash<QString, Entry> m_entries;
+    QByteArray m_pending;
+    int m_pendingCount;
+    int m_lines;
+
+    static QByteArray line(const Entry &entry);
+};
+
+#endif // REDEMPTIONJOURNAL_H
@@ -0,0 +1,167 @@
+#include "redemptionrouter.h"
+
+RedemptionRouter::RedemptionRouter(TwitchManager *twitch, ShockCollarManager *shockCollar,
+                                   SmokeMachineManager *smokeMachine, QueueLookup queues,
+                                   QObject *parent)
+    : QObject{parent}
+    , m_twitch(twitch)
+    , m_shockCollar(shockCollar)
+    , m_smokeMachine(smokeMachine)
+    , m_queues(std::move(queues))
+    , m_rules()
+    , m_queued()
+    , m_shockRewardId()
+    , m_smokeRewardId()
+{
+    connect(m_twitch, &TwitchManager::redemptionsReady, this, &RedemptionRouter::route);
+    connect(m_twitch, &TwitchManager::shockRewardChanged, this,
+            &RedemptionRouter::shockRewardChanged);
+    connect(m_twitch, &TwitchManager::smokeRewardChanged, this,
+            &RedemptionRouter::smokeRewardChanged);
+    // a shared queue only knows a device is up if the channel that last
+    // pinged it says so, a new address starts from what we know of the old
+    shockQueue()->setOnline(m_shockCollar->online());
+    smokeQueue()->setOnline(m_smokeMachine->online());
+    connect(m_shockCollar, &ShockCollarManager::onlineChanged, this,
+            [this](bool online) { shockQueue()->setOnline(online); });
+    connect(m_smokeMachine, &SmokeMachineManager::onlineChanged, this,
+            [this](bool online) { smokeQueue()->setOnline(online); });
+    connect(m_shockCollar, &ShockCollarManager::ipAddressChanged, this, [this]() {
+        shockQueue()->setOnline(m_shockCollar->online());
+        emit queuesChanged();
+    });
+    connect(m_smokeMachine, &SmokeMachineManager::ipAddressChanged, this, [this]() {
+        smokeQueue()->setOnline(m_smokeMachine->online());
+        emit queuesChanged();
+    });
+
+    // a run only counts once the device says it went off, canceling refunds
+    // the viewer, better than taking points for nothing
+    connect(m_shockCollar, &ShockCollarManager::acked, this, &RedemptionRouter::deviceAcked);
+    connect(m_smokeMachine, &SmokeMachineManager::acked, this, &RedemptionRouter::deviceAcked);
+
+    // cached rewards are already loaded by the time we exist
+    shockRewardChanged();
+    smokeRewardChanged();
+}
+
+const RedemptionRouter::Rule *RedemptionRouter::rule(const QString &rewardId) const
+{
+    const auto it = m_rules.constFind(rewardId);
+    return it == m_rules.constEnd() ? nullptr : &it.value();
+}
+
+ActionQueue *RedemptionRouter::shockQueue() const
+{
+    return m_queues(Shock, m_shockCollar->ipAddress());
+}
+
+ActionQueue *RedemptionRouter::smokeQueue() const
+{
+    return m_queues(Smoke, m_smokeMachine->ipAddress());
+}
+
+void RedemptionRouter::run(const Action &action, const QList<QString> &redemptionIds,
+                           const int &duration)
+{
+    if (action == Shock) {
+        m_shockCollar->shock(redemptionIds);
+    } else if (action == Smoke) {
+        m_smokeMachine->activate(redemptionIds, duration);
+    }
+    emit routed(action, redemptionIds);
+}
+
+void RedemptionRouter::drop(const QList<QString> &redemptionIds)
+{
+    settle(redemptionIds, u"CANCELED"_qs);
+}
+
+void RedemptionRouter::setRule(const QString &rewardId, Action action, const QVariantMap &params)
+{
+    if (rewardId.isEmpty()) {
+        return;
+    }
+    m_rules.insert(rewardId, {rewardId, action, params});
+    emit rulesChanged();
+}
+
+void RedemptionRouter::removeRule(const QString &rewardId)
+{
+    if (m_rules.remove(rewardId)) {
+        emit rulesChanged();
+    }
+}
+
+void RedemptionRouter::route(const QList<Redemption> &redemptions)
+{
+    // one queue entry per redemption, the queue's policy decides how they
+    // get batched into device runs, rewards we have no rule for belong to
+    // someone else and are left alone
+    for (const Redemption &redemption : redemptions) {
+        const auto it = m_rules.constFind(redemption.rewardId);
+        const Action action = it == m_rules.constEnd() ? NoAction : it->action;
+        if (action == NoAction || !m_twitch->claim(redemption)) {
+            continue;
+        }
+        m_queued.insert(redemption.id, redemption.rewardId);
+        switch (action) {
+        case Shock: {
+            shockQueue()->enqueue({redemption.id});
+            break;
+        }
+        case Smoke: {
+            const QVariant duration = it->params.value(u"duration"_qs);
+            smokeQueue()->enqueue({redemption.id}, duration.isValid()
+                                                       ? duration.toInt()
+                                                       : m_smokeMachine->duration());
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+void RedemptionRouter::shockRewardChanged()
+{
+    bindDeviceReward(m_shockRewardId, m_twitch->shockReward(), Shock);
+}
+
+void RedemptionRouter::smokeRewardChanged()
+{
+    bindDeviceReward(m_smokeRewardId, m_twitch->smokeReward(), Smoke);
+}
+
+void RedemptionRouter::bindDeviceReward(QString &boundId, const QVariant &reward, Action action)
+{
+    const QString id = reward.isValid() ? reward.value<Reward>().id : QString();
+    if (id == boundId) {
+        return;
+    }
+    // only drop the old rule if it's still the one we put there
+    const Rule *old = rule(boundId);
+    if (old && old->action == action) {
+        m_rules.remove(boundId);
+    }
+    boundId = id;
+    if (!id.isEmpty() && !m_rules.contains(id)) {
+        m_rules.insert(id, {id, action, {}});
+    }
+    emit rulesChanged();
+}
+
+void RedemptionRouter::deviceAcked(const QList<QString> &redemptionIds, bool success)
+{
+    settle(redemptionIds, success ? u"FULFILLED"_qs : u"CANCELED"_qs);
+}
+
+void RedemptionRouter::settle(const QList<QString> &redemptionIds, const QString &status)
+{
+    for (const QString &id : redemptionIds) {
+        const QString rewardId = m_queued.take(id);
+        if (!rewardId.isEmpty()) {
+            m_twitch->queueRedemptionUpdate(rewardId, id, status);
+        }
+    }
+}
@@ -0,0 +1,117 @@
+#ifndef REDEMPTIONROUTER_H
+#define REDEMPTIONROUTER_H
+
+#include <QHash>
+#include <QObject>
+
+#include <functional>
+
+#include "actionqueue.h"
+#include "qmlsupport.h"
+#include "shockcollarmanager.h"
+#include "smokemachinemanager.h"
+#include "twitchmanager.h"
+
+/* Hands redemptions to the devices.
+ *
+ * Each rule maps a reward id to an action and its parameters, so routing a
+ * redemption is a single hash lookup no matter how many rewards there are.
+ * Matched redemptions are claimed and go into their device's action queue,
+ * they are marked fulfilled once the device acks the run, or canceled so the
+ * viewer gets their points back if the device fails it or the queue drops
+ * them. Redemptions no rule matches are none of our business and are left
+ * for whoever owns the reward to settle.
+ *
+ * The device rewards found by title get rules of their own, which follow the
+ * reward around if it's recreated under a new id.
+ *
+ * Queues belong to the devices rather than to us, every channel pointed at
+ * the same address shares one so the gaps between runs hold across all of
+ * them. Whoever owns the queues hands each run to one router to fire, and
+ * every router sharing the device settles the redemptions that are its own.
+ */
+class RedemptionRouter : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Backend only.")
+
+  public:
+    enum Action {
+        NoAction,
+        Shock,
+        Smoke,
+    };
+    Q_ENUM(Action)
+
+    // the collar needs a moment between shocks
+    inline const static int ShockGap{2 * 1000};
+    // lets the smoke machine's relay settle, and it won't run past 90 secs
+    inline const static int SmokeGap{1000};
+    inline const static int MaxSmokeDuration{90};
+
+    struct Rule {
+        QString rewardId;
+        Action action = NoAction;
+        // per action, smoke takes a "duration" in seconds
+        QVariantMap params;
+    };
+
+    // the queue for the device of an action at an address, made if need be
+    using QueueLookup = std::function<ActionQueue *(Action action, const QString &address)>;
+
+    explicit RedemptionRouter(TwitchManager *twitch, ShockCollarManager *shockCollar,
+                              SmokeMachineManager *smokeMachine, QueueLookup queues,
+                              QObject *parent = nullptr);
+
+    QList<Rule> rules() const { return m_rules.values(); }
+    const Rule *rule(const QString &rewardId) const;
+    // for the address our devices are at right now
+    ActionQueue *shockQueue() const;
+    ActionQueue *smokeQueue() const;
+
+    bool queued(const QString &redemptionId) const { return m_queued.contains(redemptionId); }
+    // fires our device once for a shared queue's run, which can hold other
+    // channels' redemptions too, their acks get to them through the core
+    void run(const Action &action, const QList<QString> &redemptionIds, const int &duration);
+    // a shared queue gave up on these, only the ones we queued are settled
+    void drop(const QList<QString> &redemptionIds);
+
+  signals:
+    void rulesChanged();
+    // our devices moved to another address, and so to another queue
+    void queuesChanged();
+    // once a device queue has run them, for anything watching dispatch
+    void routed(Action action, const QList<QString> &redemptionIds);
+
+  public slots:
+    void setRule(const QString &rewardId, Action action, const QVariantMap &params = {});
+    void removeRule(const QString &rewardId);
+    void route(const QList<Redemption> &redemptions);
+    // from our devices or a channel sharing them, only ours are settled
+    void deviceAcked(const QList<QString> &redemptionIds, bool success);
+
+  private slots:
+    void shockRewardChanged();
+    void smokeRewardChanged();
+
+  private:
+    Q_PROPERTY(ActionQueue *shockQueue READ shockQueue NOTIFY queuesChanged)
+    Q_PROPERTY(ActionQueue *smokeQueue READ smokeQueue NOTIFY queuesChanged)
+
+    TwitchManager *m_twitch;
+    ShockCollarManager *m_shockCollar;
+    SmokeMachineManager *m_smokeMachine;
+    QueueLookup m_queues;
+    QHash<QString, Rule> m_rules;
+    // reward ids of redemptions sitting in a queue, needed to settle them
+    QHash<QString, QString> m_queued;
+    // ids the device reward rules are currently bound to
+    QString m_shockRewardId;
+    QString m_smokeRewardId;
+
+    void bindDeviceReward(QString &boundId, const QVariant &reward, Action action);
+    void settle(const QList<QString> &redemptionIds, const QString &status);
+};
+
+#endif // REDEMPTIONROUTER_H
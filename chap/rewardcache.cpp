@@ -0,0 +1,103 @@
+#include "rewardcache.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+#include "qtutils.h"
+
+RewardCache::RewardCache(const QString &path, QObject *parent)
+    : QObject{parent}
+    , m_path(path)
+    , m_persistTimer(new QTimer(this))
+    , m_writer(new QThreadPool(this))
+    , m_pending()
+{
+    m_writer->setMaxThreadCount(1);
+
+    // a refresh touches rewards one at a time, write them out once it's done
+    connect(m_persistTimer, &QTimer::timeout, this, &RewardCache::persist);
+    m_persistTimer->setSingleShot(true);
+    m_persistTimer->setInterval(500);
+}
+
+RewardCache::~RewardCache() { flush(); }
+
+QList<Reward> RewardCache::load(const QString &userId) const
+{
+    QList<Reward> rewards;
+    if (userId.isEmpty()) {
+        return rewards;
+    }
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return rewards;
+    }
+    const QJsonObject cache = QJsonDocument::fromJson(file.readAll()).object();
+    if (cache.value(u"version"_qs).toInt() != Version) {
+        qDebug() << "Ignoring reward cache from another version.";
+        return rewards;
+    }
+    if (cache.value(u"user_id"_qs).toString() != userId) {
+        qDebug() << "Ignoring reward cache for another user.";
+        return rewards;
+    }
+    for (auto value : cache.value(u"data"_qs).toArray()) {
+        rewards.append(Reward::fromJson(value.toObject()));
+    }
+    qInfo() << "Loaded cached rewards:" << rewards.count() << "from"
+            << cache.value(u"saved_at"_qs).toString();
+    return rewards;
+}
+
+void RewardCache::save(const QString &userId, const QList<Reward> &rewards)
+{
+    QJsonArray data;
+    for (const Reward &reward : rewards) {
+        data.append(reward.toJson());
+    }
+    // rewards are stored the way helix sends them so the same parsing works
+    const QJsonObject cache{
+        {u"version"_qs, Version},
+        {u"user_id"_qs, userId},
+        {u"saved_at"_qs, QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs)},
+        {u"data"_qs, data},
+    };
+    m_pending = QJsonDocument(cache).toJson(QJsonDocument::Compact);
+    if (!m_persistTimer->isActive()) {
+        m_persistTimer->start();
+    }
+}
+
+void RewardCache::clear()
+{
+    m_persistTimer->stop();
+    m_pending.clear();
+    const QString path = m_path;
+    m_writer->start([path]() { QFile::remove(path); });
+}
+
+void RewardCache::persist()
+{
+    m_persistTimer->stop();
+    if (m_pending.isEmpty()) {
+        return;
+    }
+    const QByteArray data = m_pending;
+    const QString path = m_path;
+    m_pending.clear();
+    m_writer->start([path, data]() {
+        if (!writeFileAtomic(path, data)) {
+            qWarning() << "Failed to save reward cache:" << path;
+        }
+    });
+}
+
+void RewardCache::flush()
+{
+    if (m_persistTimer->isActive()) {
+        persist();
+    }
+    m_writer->waitForDone();
+}
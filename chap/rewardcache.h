@@ -0,0 +1,47 @@
+#ifndef REWARDCACHE_H
+#define REWARDCACHE_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QTimer>
+
+#include "twitchtypes.h"
+
+/* Last known reward catalogue, kept on disk between runs.
+ *
+ * Lets us resolve the device rewards as soon as we start instead of waiting
+ * on validate and a reward fetch, the fetch still happens and whatever
+ * changed gets merged in. Saves are coalesced and written atomically on a
+ * background thread, same as the session.
+ */
+class RewardCache : public QObject
+{
+    Q_OBJECT
+
+  public:
+    // bump whenever the file layout or Reward changes shape
+    inline const static int Version{1};
+
+    explicit RewardCache(const QString &path, QObject *parent = nullptr);
+    ~RewardCache();
+
+    // cached rewards for the given user, empty if there are none or they are
+    // for someone else or from an older version
+    QList<Reward> load(const QString &userId) const;
+
+  public slots:
+    void save(const QString &userId, const QList<Reward> &rewards);
+    void clear();
+    void flush();
+
+  private slots:
+    void persist();
+
+  private:
+    QString m_path;
+    QTimer *m_persistTimer;
+    QThreadPool *m_writer;
+    QByteArray m_pending;
+};
+
+#endif // REWARDCACHE_H
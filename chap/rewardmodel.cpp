@@ -0,0 +1,155 @@
+#include "rewardmodel.h"
+
+#include <QSet>
+
+RewardModel::RewardModel(QObject *parent)
+    : QAbstractListModel{parent}
+    , m_rewards()
+    , m_byId()
+    , m_byTitle()
+{
+}
+
+int RewardModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_rewards.size();
+}
+
+QVariant RewardModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rewards.size()) {
+        return QVariant();
+    }
+    const Reward &reward = m_rewards.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+    case TitleRole:
+        return reward.title;
+    case IdRole:
+        return reward.id;
+    case PromptRole:
+        return reward.prompt;
+    case CostRole:
+        return reward.cost;
+    case EnabledRole:
+        return reward.isEnabled;
+    case PausedRole:
+        return reward.isPaused;
+    case RewardRole:
+        return QVariant::fromValue(reward);
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> RewardModel::roleNames() const
+{
+    return {
+        {IdRole, "id"},           {TitleRole, "title"},     {PromptRole, "prompt"},
+        {CostRole, "cost"},       {EnabledRole, "enabled"}, {PausedRole, "paused"},
+        {RewardRole, "reward"},
+    };
+}
+
+const Reward *RewardModel::byId(const QString &id) const
+{
+    const auto iter = m_byId.constFind(id);
+    return iter == m_byId.cend() ? nullptr : &m_rewards.at(iter.value());
+}
+
+const Reward *RewardModel::byTitle(const QString &title) const
+{
+    const auto iter = m_byTitle.constFind(title);
+    return iter == m_byTitle.cend() ? nullptr : &m_rewards.at(iter.value());
+}
+
+QVariant RewardModel::get(const QString &id) const
+{
+    const Reward *reward = byId(id);
+    return reward ? QVariant::fromValue(*reward) : QVariant();
+}
+
+QVariant RewardModel::find(const QString &title) const
+{
+    const Reward *reward = byTitle(title);
+    return reward ? QVariant::fromValue(*reward) : QVariant();
+}
+
+void RewardModel::setRewards(const QList<Reward> &rewards)
+{
+    QList<QString> removed;
+    QSet<QString> keep;
+    for (const Reward &reward : rewards) {
+        keep.insert(reward.id);
+    }
+
+    // drop anything twitch no longer has, back to front so rows stay valid,
+    // the index is rebuilt once afterwards and before anyone hears about it
+    // so lookups made from a signal handler never see a stale row
+    for (int row = m_rewards.size() - 1; row >= 0; --row) {
+        if (keep.contains(m_rewards.at(row).id)) {
+            continue;
+        }
+        removed.append(m_rewards.at(row).id);
+        beginRemoveRows(QModelIndex(), row, row);
+        m_rewards.removeAt(row);
+        endRemoveRows();
+    }
+    if (!removed.isEmpty()) {
+        reindex();
+        emit countChanged(m_rewards.size());
+        for (const QString &id : qAsConst(removed)) {
+            emit rewardChanged(id);
+        }
+    }
+
+    // changed rows and new rows are announced as they're merged in
+    for (const Reward &reward : rewards) {
+        upsert(reward);
+    }
+}
+
+void RewardModel::upsert(const Reward &reward)
+{
+    const auto iter = m_byId.constFind(reward.id);
+    if (iter != m_byId.cend()) {
+        const int row = iter.value();
+        if (m_rewards.at(row) == reward) {
+            return;
+        }
+        // only the title can move, the id is what found the row
+        const QString oldTitle = m_rewards.at(row).title;
+        if (oldTitle != reward.title) {
+            if (m_byTitle.value(oldTitle, -1) == row) {
+                m_byTitle.remove(oldTitle);
+            }
+            m_byTitle.insert(reward.title, row);
+        }
+        m_rewards[row] = reward;
+        emit dataChanged(index(row), index(row));
+        emit rewardChanged(reward.id);
+        return;
+    }
+
+    const int row = m_rewards.size();
+    beginInsertRows(QModelIndex(), row, row);
+    m_rewards.append(reward);
+    endInsertRows();
+    m_byId.insert(reward.id, row);
+    m_byTitle.insert(reward.title, row);
+    emit rewardChanged(reward.id);
+    emit countChanged(m_rewards.size());
+}
+
+void RewardModel::reindex()
+{
+    m_byId.clear();
+    m_byTitle.clear();
+    for (int row = 0; row < m_rewards.size(); ++row) {
+        m_byId.insert(m_rewards.at(row).id, row);
+        m_byTitle.insert(m_rewards.at(row).title, row);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef REWARDMODEL_H
+#define REWARDMODEL_H
+
+#include <QAbstractListModel>
+#include <QObject>
+
+#include "qmlsupport.h"
+#include "twitchtypes.h"
+
+/* The channel's custom rewards as a list model.
+ *
+ * Rewards are indexed by id and title so lookups don't walk the list, and a
+ * refresh is merged in row by row so only the rows that actually changed
+ * notify anything bound to them.
+ */
+class RewardModel : public QAbstractListModel
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Backend only.")
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+  public:
+    enum Roles {
+        IdRole = Qt::UserRole + 1,
+        TitleRole,
+        PromptRole,
+        CostRole,
+        EnabledRole,
+        PausedRole,
+        RewardRole,
+    };
+    Q_ENUM(Roles)
+
+    explicit RewardModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    QList<Reward> rewards() const { return m_rewards; }
+    const Reward *byId(const QString &id) const;
+    const Reward *byTitle(const QString &title) const;
+
+    Q_INVOKABLE QVariant get(const QString &id) const;
+    Q_INVOKABLE QVariant find(const QString &title) const;
+
+  public slots:
+    void setRewards(const QList<Reward> &rewards);
+    void upsert(const Reward &reward);
+
+  signals:
+    void countChanged(int count);
+    // emitted for every reward that was added, changed, or removed
+    void rewardChanged(const QString &id);
+
+  private:
+    QList<Reward> m_rewards;
+    QHash<QString, int> m_byId;
+    QHash<QString, int> m_byTitle;
+
+    void reindex();
+};
+
+#endif // REWARDMODEL_H
@@ -0,0 +1,93 @@
+#include "rpcclient.h"
+
+#include <QDeadlineTimer>
+#include <QDebug>
+
+RpcClient::RpcClient(QObject *parent)
+    : QObject{parent}
+    , m_socket(new QLocalSocket(this))
+    , m_buffer()
+    , m_nextId(1)
+    , m_awaiting(0)
+    , m_awaited(nullptr)
+{
+    connect(m_socket, &QLocalSocket::readyRead, this, &RpcClient::readyRead);
+    connect(m_socket, &QLocalSocket::disconnected, this, &RpcClient::disconnected);
+}
+
+bool RpcClient::connectToServer(const QString &name, const int &timeout)
+{
+    m_buffer.clear();
+    m_socket->connectToServer(name);
+    return m_socket->waitForConnected(timeout);
+}
+
+bool RpcClient::isConnected() const
+{
+    return m_socket->state() == QLocalSocket::ConnectedState;
+}
+
+quint32 RpcClient::send(const RpcFrame::Command &command, const QCborMap &args)
+{
+    RpcFrame request;
+    request.code = command;
+    request.id = m_nextId++;
+    // zero is what m_awaiting uses for nobody
+    if (m_nextId == 0) {
+        m_nextId = 1;
+    }
+    request.body = args;
+    m_socket->write(request.encode());
+    return request.id;
+}
+
+RpcFrame::Status RpcClient::call(const RpcFrame::Command &command, const QCborMap &args,
+                                 QCborMap *result, const int &timeout)
+{
+    if (!isConnected()) {
+        return RpcFrame::Failed;
+    }
+    RpcFrame reply;
+    reply.code = RpcFrame::Failed;
+    m_awaited = &reply;
+    m_awaiting = send(command, args);
+    m_socket->flush();
+
+    const QDeadlineTimer deadline(timeout);
+    while (m_awaiting != 0 && isConnected() && !deadline.hasExpired()) {
+        if (!m_socket->waitForReadyRead(static_cast<int>(deadline.remainingTime()))) {
+            break;
+        }
+    }
+    m_awaiting = 0;
+    m_awaited = nullptr;
+    if (result) {
+        *result = reply.body;
+    }
+    return static_cast<RpcFrame::Status>(reply.code);
+}
+
+void RpcClient::readyRead()
+{
+    m_buffer += m_socket->readAll();
+    qsizetype pos = 0;
+    RpcFrame reply;
+    for (;;) {
+        const RpcFrame::Parse parse = RpcFrame::decode(m_buffer, pos, reply);
+        if (parse == RpcFrame::Incomplete) {
+            break;
+        }
+        if (parse == RpcFrame::Invalid) {
+            qWarning() << "Got an invalid rpc frame, disconnecting";
+            m_buffer.clear();
+            m_socket->abort();
+            return;
+        }
+        if (m_awaiting != 0 && reply.id == m_awaiting) {
+            *m_awaited = reply;
+            m_awaiting = 0;
+        }
+        emit replied(reply.id, static_cast<RpcFrame::Status>(reply.code), reply.body);
+    }
+    m_buffer.remove(0, pos);
+}
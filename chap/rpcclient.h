@@ -0,0 +1,48 @@
+#ifndef RPCCLIENT_H
+#define RPCCLIENT_H
+
+#include <QLocalSocket>
+#include <QObject>
+
+#include "rpcframe.h"
+
+/* Talks to a running chap or chapd over the chap-rpc socket.
+ *
+ * send() doesn't wait, any number of requests can be in flight and replied()
+ * says which one each reply is for. call() is the blocking version for
+ * scripts and one-shot tools, replies to other requests that turn up while
+ * it waits are still passed on through replied().
+ */
+class RpcClient : public QObject
+{
+    Q_OBJECT
+
+  public:
+    explicit RpcClient(QObject *parent = nullptr);
+
+    bool connectToServer(const QString &name = RpcFrame::SocketName, const int &timeout = 1000);
+    bool isConnected() const;
+
+    // the request id
+    quint32 send(const RpcFrame::Command &command, const QCborMap &args = {});
+    // Failed if the connection drops or nothing comes back in time
+    RpcFrame::Status call(const RpcFrame::Command &command, const QCborMap &args = {},
+                          QCborMap *result = nullptr, const int &timeout = 1000);
+
+  signals:
+    void replied(const quint32 &id, const RpcFrame::Status &status, const QCborMap &result);
+    void disconnected();
+
+  private slots:
+    void readyRead();
+
+  private:
+    QLocalSocket *m_socket;
+    QByteArray m_buffer;
+    quint32 m_nextId;
+    // set while call() waits, so readyRead() can hand its reply over
+    quint32 m_awaiting;
+    RpcFrame *m_awaited;
+};
+
+#endif // RPCCLIENT_H
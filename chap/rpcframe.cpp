@@ -0,0 +1,67 @@
+#include "rpcframe.h"
+
+#include <QCborValue>
+#include <QtEndian>
+
+QByteArray RpcFrame::encode() const
+{
+    const QByteArray encodedBody = body.isEmpty() ? QByteArray() : body.toCborValue().toCbor();
+    QByteArray out(sizeof(quint32) + HeaderSize, Qt::Uninitialized);
+    char *data = out.data();
+    qToBigEndian<quint32>(static_cast<quint32>(HeaderSize + encodedBody.size()), data);
+    data[4] = static_cast<char>(version);
+    data[5] = static_cast<char>(code);
+    qToBigEndian<quint32>(id, data + 6);
+    return out + encodedBody;
+}
+
+RpcFrame::Parse RpcFrame::decode(const QByteArray &buffer, qsizetype &pos, RpcFrame &frame)
+{
+    if (buffer.size() - pos < static_cast<qsizetype>(sizeof(quint32))) {
+        return Incomplete;
+    }
+    const char *data = buffer.constData() + pos;
+    const quint32 length = qFromBigEndian<quint32>(data);
+    if (length < HeaderSize || length > MaxLength) {
+        return Invalid;
+    }
+    if (buffer.size() - pos < static_cast<qsizetype>(sizeof(quint32) + length)) {
+        return Incomplete;
+    }
+    frame.version = static_cast<quint8>(data[4]);
+    frame.code = static_cast<quint8>(data[5]);
+    frame.id = qFromBigEndian<quint32>(data + 6);
+    frame.body = {};
+    if (length > HeaderSize) {
+        QCborParserError error;
+        const QCborValue body = QCborValue::fromCbor(
+            QByteArray::fromRawData(data + 10, length - HeaderSize), &error);
+        if (error.error != QCborError::NoError || !body.isMap()) {
+            return Invalid;
+        }
+        frame.body = body.toMap();
+    }
+    pos += sizeof(quint32) + length;
+    return Complete;
+}
+
+QString RpcFrame::statusName(const quint8 &status)
+{
+    switch (status) {
+    case Ok:
+        return u"ok"_qs;
+    case Failed:
+        return u"failed"_qs;
+    case BadRequest:
+        return u"bad request"_qs;
+    case UnknownCommand:
+        return u"unknown command"_qs;
+    case Unsupported:
+        return u"unsupported"_qs;
+    case UnknownChannel:
+        return u"unknown channel"_qs;
+    case BadVersion:
+        return u"bad version"_qs;
+    }
+    return u"status %1"_qs.arg(status);
+}
@@ -0,0 +1,76 @@
+#ifndef RPCFRAME_H
+#define RPCFRAME_H
+
+#include <QByteArray>
+#include <QCborMap>
+#include <QString>
+
+/* One message on the chap-rpc socket, either way.
+ *
+ * On the wire every frame is
+ *
+ *   quint32 length   bytes after this field, big endian
+ *   quint8  version  Version, a server answers others with BadVersion
+ *   quint8  code     a Command going in, a Status coming back
+ *   quint32 id       picked by the client, echoed in the reply
+ *   ...     body     a cbor map, may be left out when empty
+ *
+ * The length prefix is what lets a reader cope with a frame split across
+ * reads or several arriving in one, and the id is what lets a client keep
+ * more than one request in flight and match up the replies.
+ */
+struct RpcFrame {
+    enum Command : quint8 {
+        Ping = 1,
+        // {url}, a chap:// login callback
+        Callback,
+        // {channel}, state of a channel and its devices
+        Query,
+        // {channel}
+        Shock,
+        // {channel, duration}, seconds and zero for the configured duration
+        Smoke,
+        // reserved for the hammer, nothing drives it yet
+        Hammer,
+    };
+
+    enum Status : quint8 {
+        Ok = 0,
+        Failed,
+        // the body is missing something or doesn't make sense
+        BadRequest,
+        // a code newer than we know about
+        UnknownCommand,
+        // a command we know but this build doesn't handle
+        Unsupported,
+        UnknownChannel,
+        // the reply carries the version the server speaks
+        BadVersion,
+    };
+
+    enum Parse {
+        Incomplete,
+        Complete,
+        // garbage, there is no telling where the next frame starts
+        Invalid,
+    };
+
+    inline const static QString SocketName{u"chap-rpc"_qs};
+    inline const static quint8 Version{1};
+    // version, code and id
+    inline const static qsizetype HeaderSize{6};
+    // anything bigger isn't something we would send
+    inline const static quint32 MaxLength{64 * 1024};
+
+    quint8 version = Version;
+    quint8 code = 0;
+    quint32 id = 0;
+    QCborMap body;
+
+    QByteArray encode() const;
+    // the frame at pos in buffer, pos is moved past it when it is complete
+    static Parse decode(const QByteArray &buffer, qsizetype &pos, RpcFrame &frame);
+    static QString statusName(const quint8 &status);
+};
+
+#endif // RPCFRAME_H
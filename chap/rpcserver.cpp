@@ -0,0 +1,93 @@
+#include "rpcserver.h"
+
+#include <QDebug>
+
+RpcServer::RpcServer(QObject *parent)
+    : QObject{parent}
+    , m_server(new QLocalServer(this))
+    , m_handlers()
+    , m_buffers()
+{
+    connect(m_server, &QLocalServer::newConnection, this, &RpcServer::newConnection);
+}
+
+bool RpcServer::listen(const QString &name)
+{
+    if (!m_server->listen(name)) {
+        qWarning() << "Failed to listen on" << name << m_server->errorString();
+        return false;
+    }
+    return true;
+}
+
+void RpcServer::handle(const RpcFrame::Command &command, Handler handler)
+{
+    m_handlers.insert(command, std::move(handler));
+}
+
+void RpcServer::newConnection()
+{
+    while (QLocalSocket *conn = m_server->nextPendingConnection()) {
+        m_buffers.insert(conn, {});
+        connect(conn, &QLocalSocket::readyRead, this, &RpcServer::readyRead);
+        connect(conn, &QLocalSocket::disconnected, this, [this, conn]() {
+            m_buffers.remove(conn);
+            conn->deleteLater();
+        });
+    }
+}
+
+void RpcServer::readyRead()
+{
+    QLocalSocket *conn = qobject_cast<QLocalSocket *>(QObject::sender());
+    QByteArray &buffer = m_buffers[conn];
+    buffer += conn->readAll();
+
+    QByteArray replies;
+    qsizetype pos = 0;
+    RpcFrame request;
+    for (;;) {
+        const RpcFrame::Parse parse = RpcFrame::decode(buffer, pos, request);
+        if (parse == RpcFrame::Incomplete) {
+            break;
+        }
+        if (parse == RpcFrame::Invalid) {
+            qWarning() << "Dropping rpc connection that sent an invalid frame";
+            conn->write(replies);
+            buffer.clear();
+            conn->disconnectFromServer();
+            return;
+        }
+        replies += answer(request).encode();
+    }
+    // only what's left of a partial frame stays behind
+    buffer.remove(0, pos);
+    if (!replies.isEmpty()) {
+        conn->write(replies);
+    }
+}
+
+RpcFrame RpcServer::answer(const RpcFrame &request)
+{
+    RpcFrame reply;
+    reply.id = request.id;
+    if (request.version != RpcFrame::Version) {
+        reply.code = RpcFrame::BadVersion;
+        return reply;
+    }
+    if (request.code == RpcFrame::Ping) {
+        reply.code = RpcFrame::Ok;
+        return reply;
+    }
+    if (request.code < RpcFrame::Ping || request.code > RpcFrame::Hammer) {
+        reply.code = RpcFrame::UnknownCommand;
+        return reply;
+    }
+    const auto handler = m_handlers.constFind(request.code);
+    if (handler == m_handlers.cend()) {
+        reply.code = RpcFrame::Unsupported;
+        return reply;
+    }
+    reply.code = (*handler)(request.body, reply.body);
+    return reply;
+}
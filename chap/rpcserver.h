@@ -0,0 +1,51 @@
+#ifndef RPCSERVER_H
+#define RPCSERVER_H
+
+#include <QHash>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QObject>
+
+#include <functional>
+
+#include "rpcframe.h"
+
+/* Answers RpcFrame commands on a local socket.
+ *
+ * Whatever arrives is buffered per connection and every complete frame in it
+ * is answered in order, replies for one read go out in a single write so a
+ * client pipelining requests isn't paying a syscall each. Ping is answered
+ * here, everything else goes to the handler registered for it and commands
+ * without one are answered with Unsupported. Handlers run on our thread and
+ * answer right away, anything slow should be kicked off and reported on
+ * through Query instead.
+ *
+ * A connection that sends something we can't frame is dropped, there is no
+ * way to find where the next frame starts.
+ */
+class RpcServer : public QObject
+{
+    Q_OBJECT
+
+  public:
+    using Handler = std::function<RpcFrame::Status(const QCborMap &args, QCborMap &result)>;
+
+    explicit RpcServer(QObject *parent = nullptr);
+
+    bool listen(const QString &name = RpcFrame::SocketName);
+    void handle(const RpcFrame::Command &command, Handler handler);
+
+  private slots:
+    void newConnection();
+    void readyRead();
+
+  private:
+    QLocalServer *m_server;
+    QHash<quint8, Handler> m_handlers;
+    // what has arrived of each connection's next frame
+    QHash<QLocalSocket *, QByteArray> m_buffers;
+
+    RpcFrame answer(const RpcFrame &request);
+};
+
+#endif // RPCSERVER_H
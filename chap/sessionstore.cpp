@@ -0,0 +1,153 @@
+#include "sessionstore.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QSettings>
+
+#include "qtutils.h"
+
+SessionStore::SessionStore(const QString &path, QObject *parent)
+    : QObject{parent}
+    , m_path(path)
+    , m_persistTimer(new QTimer(this))
+    , m_writer(new QThreadPool(this))
+    , m_accessToken()
+    , m_refreshToken()
+    , m_login()
+    , m_userId()
+    , m_expiresAt()
+    , m_refreshJitter(0)
+{
+    m_writer->setMaxThreadCount(1);
+
+    // changes are written out a moment after they stop coming in
+    connect(m_persistTimer, &QTimer::timeout, this, &SessionStore::persist);
+    m_persistTimer->setSingleShot(true);
+    m_persistTimer->setInterval(100);
+
+    load();
+}
+
+SessionStore::~SessionStore() { flush(); }
+
+void SessionStore::load()
+{
+    QFile file(m_path);
+    if (file.open(QIODevice::ReadOnly)) {
+        const QJsonObject session = QJsonDocument::fromJson(file.readAll()).object();
+        m_accessToken = session.value(u"AccessToken"_qs).toString();
+        m_refreshToken = session.value(u"RefreshToken"_qs).toString();
+        m_login = session.value(u"Login"_qs).toString();
+        m_userId = session.value(u"UserId"_qs).toString();
+        m_expiresAt =
+            QDateTime::fromString(session.value(u"ExpiresAt"_qs).toString(), Qt::ISODateWithMs);
+        // sessions saved before there was one get theirs now
+        if (session.contains(u"RefreshJitter"_qs)) {
+            m_refreshJitter = session.value(u"RefreshJitter"_qs).toInt();
+        } else if (!m_accessToken.isEmpty()) {
+            m_refreshJitter = QRandomGenerator::global()->bounded(RefreshJitter);
+            changed();
+        }
+        return;
+    }
+
+    // older versions kept the session in settings, bring it over once
+    QSettings settings;
+    if (settings.childGroups().contains(u"TwitchSession"_qs)) {
+        settings.beginGroup(u"TwitchSession"_qs);
+        m_accessToken = settings.value(u"AccessToken"_qs).toString();
+        m_refreshToken = settings.value(u"RefreshToken"_qs).toString();
+        m_login = settings.value(u"Login"_qs).toString();
+        m_userId = settings.value(u"UserId"_qs).toString();
+        m_refreshJitter = QRandomGenerator::global()->bounded(RefreshJitter);
+        settings.endGroup();
+        // the old copy only goes once the new one is on disk, a crash in
+        // between would otherwise lose the session
+        if (!writeFileAtomic(m_path, toJson())) {
+            qWarning() << "Failed to migrate session:" << m_path;
+            return;
+        }
+        settings.remove(u"TwitchSession"_qs);
+        qInfo() << "Migrated session from settings.";
+    }
+}
+
+void SessionStore::setTokens(const QString &accessToken, const QString &refreshToken,
+                             const QDateTime &expiresAt)
+{
+    m_accessToken = accessToken;
+    m_refreshToken = refreshToken;
+    m_expiresAt = expiresAt;
+    m_refreshJitter = QRandomGenerator::global()->bounded(RefreshJitter);
+    changed();
+}
+
+void SessionStore::setExpiresAt(const QDateTime &expiresAt)
+{
+    if (m_expiresAt == expiresAt) {
+        return;
+    }
+    m_expiresAt = expiresAt;
+    changed();
+}
+
+void SessionStore::setUser(const QString &login, const QString &userId)
+{
+    m_login = login;
+    m_userId = userId;
+    changed();
+}
+
+void SessionStore::clear()
+{
+    m_accessToken.clear();
+    m_refreshToken.clear();
+    m_login.clear();
+    m_userId.clear();
+    m_expiresAt = QDateTime();
+    m_refreshJitter = 0;
+    changed();
+}
+
+void SessionStore::changed()
+{
+    if (!m_persistTimer->isActive()) {
+        m_persistTimer->start();
+    }
+}
+
+void SessionStore::persist()
+{
+    m_persistTimer->stop();
+    const QByteArray data = toJson();
+    const QString path = m_path;
+    m_writer->start([path, data]() {
+        if (!writeFileAtomic(path, data)) {
+            qWarning() << "Failed to save session:" << path;
+        }
+    });
+}
+
+QByteArray SessionStore::toJson() const
+{
+    const QJsonObject session{
+        {u"AccessToken"_qs, m_accessToken},
+        {u"RefreshToken"_qs, m_refreshToken},
+        {u"Login"_qs, m_login},
+        {u"UserId"_qs, m_userId},
+        {u"ExpiresAt"_qs, m_expiresAt.toUTC().toString(Qt::ISODateWithMs)},
+        {u"RefreshJitter"_qs, m_refreshJitter},
+    };
+    return QJsonDocument(session).toJson(QJsonDocument::Compact);
+}
+
+void SessionStore::flush()
+{
+    // on the way out we need the last write to actually land
+    if (m_persistTimer->isActive()) {
+        persist();
+    }
+    m_writer->waitForDone();
+}
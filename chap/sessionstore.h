@@ -0,0 +1,67 @@
+#ifndef SESSIONSTORE_H
+#define SESSIONSTORE_H
+
+#include <QDateTime>
+#include <QObject>
+#include <QThreadPool>
+#include <QTimer>
+
+/* Twitch session credentials, held in memory.
+ *
+ * Everything is loaded once at startup and served from memory after that.
+ * Changes are written out on a background thread, a burst of changes gets
+ * coalesced into a single write, and the file is replaced atomically so a
+ * crash mid-write can't leave us with half a session.
+ */
+class SessionStore : public QObject
+{
+    Q_OBJECT
+
+  public:
+    // most seconds a token's refresh is moved ahead by, so two instances
+    // started together don't keep refreshing in lockstep
+    inline const static int RefreshJitter{60};
+
+    explicit SessionStore(const QString &path, QObject *parent = nullptr);
+    ~SessionStore();
+
+    QString accessToken() const { return m_accessToken; }
+    QString refreshToken() const { return m_refreshToken; }
+    QString login() const { return m_login; }
+    QString userId() const { return m_userId; }
+    // when the access token stops working, invalid if we don't know
+    QDateTime expiresAt() const { return m_expiresAt; }
+    // picked when the tokens are stored and kept for as long as they are
+    int refreshJitter() const { return m_refreshJitter; }
+
+    void setTokens(const QString &accessToken, const QString &refreshToken,
+                   const QDateTime &expiresAt);
+    void setExpiresAt(const QDateTime &expiresAt);
+    void setUser(const QString &login, const QString &userId);
+    void clear();
+
+  public slots:
+    void flush();
+
+  private slots:
+    void persist();
+
+  private:
+    QString m_path;
+    QTimer *m_persistTimer;
+    // single thread so writes land in the order they were made
+    QThreadPool *m_writer;
+
+    QString m_accessToken;
+    QString m_refreshToken;
+    QString m_login;
+    QString m_userId;
+    QDateTime m_expiresAt;
+    int m_refreshJitter;
+
+    void load();
+    void changed();
+    QByteArray toJson() const;
+};
+
+#endif // SESSIONSTORE_H
@@ -2,9 +2,9 @@
 
 #include <QNetworkAccessManager>
 
-ShockCollarManager::ShockCollarManager(QObject *parent)
+ShockCollarManager::ShockCollarManager(QNetworkAccessManager *nam, QObject *parent)
     : QObject{parent}
-    , m_nam(new QNetworkAccessManager(this))
+    , m_nam(nam ? nam : new QNetworkAccessManager(this))
     , m_pingTimer(new QTimer(this))
     , m_online(false)
     , m_ipAddress(u"192.168.1.220"_qs)
@@ -14,7 +14,6 @@ ShockCollarManager::ShockCollarManager(QObject *parent)
     m_pingTimer->setSingleShot(false);
     m_pingTimer->setInterval(10 * 1000);
     m_pingTimer->start();
-    QTimer::singleShot(5000, this, &ShockCollarManager::ping);
 }
 
 void ShockCollarManager::ping()
@@ -22,6 +21,7 @@ void ShockCollarManager::ping()
     QNetworkRequest request(PingUrl.arg(m_ipAddress));
     QNetworkReply *reply = m_nam->get(request);
     QTimer::singleShot(5000, reply, &QNetworkReply::abort); // timeout after 5 seconds
+    reply->setProperty("sentAt", steadyMicros());
     connect(reply, &QNetworkReply::finished, this, &ShockCollarManager::pingFinished);
 }
 
@@ -36,23 +36,28 @@ void ShockCollarManager::pingFinished()
         qWarning() << "Shock collar went offline!";
     }
     setOnline(online);
+    emit pinged(steadyMicros() - reply->property("sentAt").toLongLong(), online);
 }
 
-void ShockCollarManager::shock()
+void ShockCollarManager::shock(const QList<QString> &redemptionIds)
 {
     QNetworkRequest request(ShockUrl.arg(m_ipAddress));
     request.setHeader(QNetworkRequest::ContentTypeHeader, "text/plain");
     QNetworkReply *reply = m_nam->post(request, "");
     QTimer::singleShot(5000, reply, &QNetworkReply::abort); // timeout after 5 seconds
+    reply->setProperty("redemptionIds", QVariant::fromValue(redemptionIds));
     connect(reply, &QNetworkReply::finished, this, &ShockCollarManager::shockFinished);
+    emit dispatched(redemptionIds);
 }
 
 void ShockCollarManager::shockFinished()
 {
     QNetworkReply *reply = qobject_cast<QNetworkReply *>(QObject::sender());
-    if (reply->error() == QNetworkReply::NoError) {
+    const bool success = reply->error() == QNetworkReply::NoError;
+    if (success) {
         qInfo() << "Shock administered!";
     } else {
         qWarning() << "Failed to administer shock!";
     }
+    emit acked(reply->property("redemptionIds").value<QList<QString>>(), success);
 }
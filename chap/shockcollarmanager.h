@@ -2,8 +2,8 @@
 #define SHOCKCOLLARMANAGER_H
 
 #include <QObject>
-#include <QtQml>
 
+#include "qmlsupport.h"
 #include "qtutils.h"
 
 class ShockCollarManager : public QObject
@@ -18,13 +18,22 @@ class ShockCollarManager : public QObject
     // for triggering shock
     inline const static QString ShockUrl{u"http://%1/shock"_qs};
 
-    explicit ShockCollarManager(QObject *parent = nullptr);
+    // a network manager is made for us if none is shared with us
+    explicit ShockCollarManager(QNetworkAccessManager *nam = nullptr, QObject *parent = nullptr);
+
+  signals:
+    // redemptions that triggered a shock, once it's sent and once it's done
+    void dispatched(const QList<QString> &redemptionIds);
+    void acked(const QList<QString> &redemptionIds, bool success);
+    // round trip of every ping, answered or not
+    void pinged(const qint64 &micros, bool success);
 
   public slots:
-    void shock();
+    void shock(const QList<QString> &redemptionIds = {});
+    // the first one is up to the core's startup pipeline
+    void ping();
 
   private slots:
-    void ping();
     void pingFinished();
     void shockFinished();
 
@@ -2,9 +2,9 @@
 
 #include <QNetworkAccessManager>
 
-SmokeMachineManager::SmokeMachineManager(QObject *parent)
+SmokeMachineManager::SmokeMachineManager(QNetworkAccessManager *nam, QObject *parent)
     : QObject{parent}
-    , m_nam(new QNetworkAccessManager(this))
+    , m_nam(nam ? nam : new QNetworkAccessManager(this))
     , m_pingTimer(new QTimer(this))
     , m_online(false)
     , m_ipAddress(u"192.168.1.224"_qs)
@@ -15,7 +15,6 @@ SmokeMachineManager::SmokeMachineManager(QObject *parent)
     m_pingTimer->setSingleShot(false);
     m_pingTimer->setInterval(10 * 1000);
     m_pingTimer->start();
-    QTimer::singleShot(5000, this, &SmokeMachineManager::ping);
 }
 
 void SmokeMachineManager::ping()
@@ -23,6 +22,7 @@ void SmokeMachineManager::ping()
     QNetworkRequest request(PingUrl.arg(m_ipAddress));
     QNetworkReply *reply = m_nam->get(request);
     QTimer::singleShot(5000, reply, &QNetworkReply::abort); // timeout after 5 seconds
+    reply->setProperty("sentAt", steadyMicros());
     connect(reply, &QNetworkReply::finished, this, &SmokeMachineManager::pingFinished);
 }
 
@@ -37,23 +37,28 @@ void SmokeMachineManager::pingFinished()
         qWarning() << "Smoke machine went offline!";
     }
     setOnline(online);
+    emit pinged(steadyMicros() - reply->property("sentAt").toLongLong(), online);
 }
 
-void SmokeMachineManager::activate()
+void SmokeMachineManager::activate(const QList<QString> &redemptionIds, const int &duration)
 {
-    QNetworkRequest request(ActivateUrl.arg(m_ipAddress).arg(m_duration));
+    QNetworkRequest request(ActivateUrl.arg(m_ipAddress).arg(duration > 0 ? duration : m_duration));
     request.setHeader(QNetworkRequest::ContentTypeHeader, "text/plain");
     QNetworkReply *reply = m_nam->post(request, "");
     QTimer::singleShot(5000, reply, &QNetworkReply::abort); // timeout after 5 seconds
+    reply->setProperty("redemptionIds", QVariant::fromValue(redemptionIds));
     connect(reply, &QNetworkReply::finished, this, &SmokeMachineManager::activateFinished);
+    emit dispatched(redemptionIds);
 }
 
 void SmokeMachineManager::activateFinished()
 {
     QNetworkReply *reply = qobject_cast<QNetworkReply *>(QObject::sender());
-    if (reply->error() == QNetworkReply::NoError) {
+    const bool success = reply->error() == QNetworkReply::NoError;
+    if (success) {
         qInfo() << "Smoke active!";
     } else {
         qWarning() << "Failed to activate smoke!";
     }
+    emit acked(reply->property("redemptionIds").value<QList<QString>>(), success);
 }
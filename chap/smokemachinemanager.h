@@ -2,8 +2,8 @@
 #define SMOKEMACHINEMANAGER_H
 
 #include <QObject>
-#include <QtQml>
 
+#include "qmlsupport.h"
 #include "qtutils.h"
 
 class SmokeMachineManager : public QObject
@@ -18,13 +18,23 @@ class SmokeMachineManager : public QObject
     // for triggering smoke
     inline const static QString ActivateUrl{u"http://%1/activate?duration=%2"_qs};
 
-    explicit SmokeMachineManager(QObject *parent = nullptr);
+    // a network manager is made for us if none is shared with us
+    explicit SmokeMachineManager(QNetworkAccessManager *nam = nullptr, QObject *parent = nullptr);
+
+  signals:
+    // redemptions that triggered smoke, once it's sent and once it's done
+    void dispatched(const QList<QString> &redemptionIds);
+    void acked(const QList<QString> &redemptionIds, bool success);
+    // round trip of every ping, answered or not
+    void pinged(const qint64 &micros, bool success);
 
   public slots:
-    void activate();
+    // a duration of zero runs for the configured duration
+    void activate(const QList<QString> &redemptionIds = {}, const int &duration = 0);
+    // the first one is up to the core's startup pipeline
+    void ping();
 
   private slots:
-    void ping();
     void pingFinished();
     void activateFinished();
 
@@ -0,0 +1,109 @@
+#include "startuppipeline.h"
+
+#include "startuptracer.h"
+
+StartupPipeline::StartupPipeline(QObject *parent)
+    : QObject{parent}
+    , m_clock()
+    , m_running(false)
+    , m_steps()
+    , m_order()
+{
+    m_clock.start();
+}
+
+void StartupPipeline::add(const QString &name, const QList<QString> &after, Step step)
+{
+    if (m_steps.contains(name)) {
+        qWarning() << "Startup step added twice:" << name;
+        return;
+    }
+    m_steps.insert(name, {after, std::move(step)});
+    m_order.append(name);
+    if (m_running) {
+        runReady();
+    }
+}
+
+bool StartupPipeline::isDone(const QString &name) const
+{
+    return m_steps.value(name).finishedAt >= 0;
+}
+
+qint64 StartupPipeline::finishedAt(const QString &name) const
+{
+    return m_steps.value(name).finishedAt;
+}
+
+QVariantMap StartupPipeline::timings() const
+{
+    QVariantMap timings;
+    for (auto it = m_steps.cbegin(); it != m_steps.cend(); ++it) {
+        if (it->finishedAt >= 0) {
+            timings.insert(it.key(), it->finishedAt);
+        }
+    }
+    return timings;
+}
+
+void StartupPipeline::start()
+{
+    if (m_running) {
+        return;
+    }
+    m_running = true;
+    // a step waiting on one nobody added would never run, say so up front
+    for (auto it = m_steps.cbegin(); it != m_steps.cend(); ++it) {
+        for (const QString &after : it->after) {
+            if (!m_steps.contains(after)) {
+                qWarning() << "Startup step" << it.key() << "waits on unknown step" << after;
+            }
+        }
+    }
+    runReady();
+}
+
+bool StartupPipeline::ready(const Entry &entry) const
+{
+    for (const QString &after : entry.after) {
+        if (!isDone(after)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void StartupPipeline::runReady()
+{
+    for (const QString &name : qAsConst(m_order)) {
+        Entry &entry = m_steps[name];
+        if (entry.started || !ready(entry)) {
+            continue;
+        }
+        entry.started = true;
+        QMetaObject::invokeMethod(
+            this,
+            [this, name]() {
+                Entry &entry = m_steps[name];
+                entry.startedAt = m_clock.elapsed();
+                entry.startedMicros = steadyMicros();
+                entry.step([this, name]() { finish(name); });
+            },
+            Qt::QueuedConnection);
+    }
+}
+
+void StartupPipeline::finish(const QString &name)
+{
+    Entry &entry = m_steps[name];
+    if (entry.finishedAt >= 0) {
+        return;
+    }
+    entry.finishedAt = m_clock.elapsed();
+    StartupTracer::record(name, entry.startedMicros, steadyMicros());
+    qDebug().noquote() << u"Startup %1 done at %2 ms, took %3 ms"_qs.arg(name)
+                              .arg(entry.finishedAt)
+                              .arg(entry.finishedAt - entry.startedAt);
+    emit stepFinished(name, entry.finishedAt);
+    runReady();
+}
@@ -0,0 +1,76 @@
+#ifndef STARTUPPIPELINE_H
+#define STARTUPPIPELINE_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+
+#include <functional>
+
+#include "qmlsupport.h"
+#include "qtutils.h"
+
+/* Runs startup as a set of steps that only wait on what they really need.
+ *
+ * Each step names the steps it has to come after, everything else starts as
+ * soon as start() is called, so network round trips overlap each other and
+ * whatever the main thread is busy with instead of queueing up behind it.
+ * Steps are handed a done callback and finish whenever they call it, right
+ * away or once a reply comes back, calling it again does nothing.
+ *
+ * Ready steps are posted to the event loop in the order they were added so a
+ * step that blocks the thread for a while, like loading qml, can be added
+ * last and still let the ones ahead of it get their requests out first.
+ * Steps added after start() run as soon as what they wait on is done.
+ *
+ * Every step also lands in the StartupTracer so it shows up in the summary
+ * alongside the phases main() times itself.
+ */
+class StartupPipeline : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Backend only.")
+
+  public:
+    using Done = std::function<void()>;
+    using Step = std::function<void(Done)>;
+
+    explicit StartupPipeline(QObject *parent = nullptr);
+
+    void add(const QString &name, const QList<QString> &after, Step step);
+    bool isDone(const QString &name) const;
+    // msecs from when we were created, -1 until it is done
+    qint64 finishedAt(const QString &name) const;
+    // step name to msecs it finished at, for the log and qml
+    Q_INVOKABLE QVariantMap timings() const;
+
+  signals:
+    void stepFinished(const QString &name, const qint64 &msecs);
+
+  public slots:
+    void start();
+
+  private:
+    struct Entry {
+        QList<QString> after;
+        Step step;
+        bool started = false;
+        qint64 startedAt = -1;
+        qint64 finishedAt = -1;
+        // steadyMicros() when it started, for the tracer
+        qint64 startedMicros = 0;
+    };
+
+    QElapsedTimer m_clock;
+    bool m_running;
+    QHash<QString, Entry> m_steps;
+    // names in the order they were added
+    QList<QString> m_order;
+
+    bool ready(const Entry &entry) const;
+    void runReady();
+    void finish(const QString &name);
+};
+
+#endif // STARTUPPIPELINE_H
@@ -0,0 +1,91 @@
+#include "startuptracer.h"
+
+#include <QDebug>
+
+#include <algorithm>
+
+#include "qtutils.h"
+
+QList<StartupTracer::Phase> &StartupTracer::phases()
+{
+    static QList<Phase> phases;
+    return phases;
+}
+
+qint64 StartupTracer::launchedAt()
+{
+    // steadyMicros() starts counting the first time anyone asks
+    static const qint64 launchedAt = steadyMicros();
+    return launchedAt;
+}
+
+void StartupTracer::begin(const QString &phase)
+{
+    launchedAt();
+    phases().append({phase, steadyMicros()});
+}
+
+void StartupTracer::end(const QString &phase)
+{
+    const qint64 now = steadyMicros();
+    // the latest one of that name, a phase can run more than once
+    QList<Phase> &all = phases();
+    for (auto it = all.rbegin(); it != all.rend(); ++it) {
+        if (it->name == phase && it->end < 0) {
+            it->end = now;
+            return;
+        }
+    }
+    qWarning() << "Startup phase ended without beginning:" << phase;
+}
+
+void StartupTracer::record(const QString &phase, const qint64 &startMicros,
+                           const qint64 &endMicros)
+{
+    launchedAt();
+    phases().append({phase, startMicros, endMicros});
+}
+
+double StartupTracer::endedAt(const QString &phase)
+{
+    for (const Phase &entry : qAsConst(phases())) {
+        if (entry.name == phase && entry.end >= 0) {
+            return (entry.end - launchedAt()) / 1000.0;
+        }
+    }
+    return -1;
+}
+
+QString StartupTracer::summary()
+{
+    QList<Phase> sorted = phases();
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const Phase &a, const Phase &b) { return a.start < b.start; });
+    QString out = u"Startup trace, msecs from launch:"_qs;
+    for (const Phase &phase : qAsConst(sorted)) {
+        const double start = (phase.start - launchedAt()) / 1000.0;
+        if (phase.end < 0) {
+            out += u"\n  %1 %2 unfinished"_qs.arg(start, 8, 'f', 1).arg(phase.name, -20);
+        } else if (phase.end == phase.start) {
+            out += u"\n  %1 %2"_qs.arg(start, 8, 'f', 1).arg(phase.name, -20);
+        } else {
+            out += u"\n  %1 %2 took %3"_qs.arg(start, 8, 'f', 1)
+                       .arg(phase.name, -20)
+                       .arg((phase.end - phase.start) / 1000.0, 0, 'f', 1);
+        }
+    }
+    return out;
+}
+
+QJsonObject StartupTracer::report()
+{
+    QJsonObject report;
+    for (const Phase &phase : qAsConst(phases())) {
+        report.insert(phase.name,
+                      QJsonObject{
+                          {u"start"_qs, (phase.start - launchedAt()) / 1000.0},
+                          {u"end"_qs, phase.end < 0 ? -1 : (phase.end - launchedAt()) / 1000.0},
+                      });
+    }
+    return report;
+}
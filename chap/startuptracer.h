@@ -0,0 +1,40 @@
+#ifndef STARTUPTRACER_H
+#define STARTUPTRACER_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+/* Where the time goes between launch and the first frame.
+ *
+ * Phases are timed on the steadyMicros() clock, so the first begin() in
+ * main() is time zero for everything after it. The startup pipeline records
+ * its steps here too, one summary covers both. Main thread only.
+ */
+class StartupTracer
+{
+  public:
+    static void begin(const QString &phase);
+    static void end(const QString &phase);
+    // a phase timed somewhere else, on the steadyMicros() clock
+    static void record(const QString &phase, const qint64 &startMicros, const qint64 &endMicros);
+
+    // msecs from launch until the phase ended, -1 if it hasn't
+    static double endedAt(const QString &phase);
+    // one line per phase in the order they started
+    static QString summary();
+    // phase to {start, end} in msecs from launch
+    static QJsonObject report();
+
+  private:
+    struct Phase {
+        QString name;
+        qint64 start;
+        qint64 end = -1;
+    };
+
+    static QList<Phase> &phases();
+    static qint64 launchedAt();
+};
+
+#endif // STARTUPTRACER_H
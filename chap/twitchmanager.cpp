@@ -1,38 +1,158 @@
 #include "twitchmanager.h"
 
-#include <QDesktopServices>
+#include <QDir>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QMetaMethod>
 #include <QNetworkAccessManager>
+#include <QStandardPaths>
 #include <QUuid>
+#ifndef CHAP_HEADLESS
+#include <QDesktopServices>
+#endif
 
+#include "helixparser.h"
 #include "secrets.h"
 
-TwitchManager::TwitchManager(QObject *parent)
+TwitchManager::TwitchManager(HelixScheduler *scheduler, const QString &channel,
+                             QObject *parent)
     : QObject{parent}
-    , m_nam(new QNetworkAccessManager(this))
-    , m_validateTimer(new QTimer(this))
+    , m_channel(channel)
+    , m_scheduler(scheduler ? scheduler
+                            : new HelixScheduler(new QNetworkAccessManager(this), this))
+    , m_eventSub(new EventSubClient(this))
+    , m_eventSubStandIn(false)
+    , m_standInUrl()
+    , m_session(new SessionStore(dataPath(channel) + u"/session.json"_qs, this))
+    , m_rewards(new RewardModel(this))
+    , m_rewardCache(new RewardCache(dataPath(channel) + u"/rewards.json"_qs, this))
+    , m_authTimer(new QTimer(this))
+    , m_validatedAt()
+    , m_updateTimer(new QTimer(this))
     , m_expectedState()
+    , m_pendingUpdates()
+    , m_syncs()
+    , m_seen()
+    , m_journal(new RedemptionJournal(dataPath(channel) + u"/redemptions.journal"_qs, this))
+    , m_requests()
+    , m_nextRequestId(1)
     , m_accessToken()
     , m_userId()
     , m_loading(false)
+    , m_inFlight(0)
+    , m_authorizing(false)
+    , m_fetchingRewards(false)
+    , m_updatingRewards(false)
+    , m_fetchingRedemptions(false)
+    , m_updatingRedemptions(false)
     , m_loggedIn(false)
     , m_autoLogin(false)
     , m_userName()
-    , m_rewards()
+    , m_shockReward()
+    , m_smokeReward()
 {
+    QDir().mkpath(dataPath(m_channel));
     QSettings settings;
-    settings.beginGroup(u"Twitch"_qs);
+    settings.beginGroup(m_channel.isEmpty() ? u"Twitch"_qs : u"Channels/"_qs + m_channel);
     m_autoLogin = settings.value(u"AutoLogin"_qs).toBool();
     settings.endGroup();
 
+    // open connections to both twitch hosts now so startup validate and the
+    // first redemption don't wait on DNS and TLS
+    m_scheduler->warmUp({TokenUrl, RewardsUrl});
+
     // we are required to validate our tokens on startup and every hour while
-    // running or risk an audit or throttling
-    connect(m_validateTimer, &QTimer::timeout, this, [&]() { validate(); });
-    m_validateTimer->setSingleShot(false);
-    m_validateTimer->setInterval(1000 * 60 * 60);
-    m_validateTimer->start();
-    QTimer::singleShot(1000, this, [&]() { validate(); });
+    // running or risk an audit or throttling, the same timer refreshes the
+    // tokens a little before they expire so requests never go out with a
+    // dead token, whichever is due first is what it gets started for, the
+    // startup validate is left to the core's startup pipeline
+    connect(m_authTimer, &QTimer::timeout, this, &TwitchManager::authTimeout);
+    m_authTimer->setSingleShot(true);
+
+    // redemption updates are collected for a short window so a burst of them
+    // goes out as a few multi-id requests instead of one request each
+    connect(m_updateTimer, &QTimer::timeout, this, &TwitchManager::flushRedemptionUpdates);
+    m_updateTimer->setSingleShot(true);
+    m_updateTimer->setInterval(250);
+
+    // only the rows that changed get touched when rewards are refreshed
+    connect(m_rewards, &RewardModel::rewardChanged, this, &TwitchManager::rewardChanged);
+
+    // start from the last session and rewards we knew about so redemptions
+    // can be handled right away, validate and the reward fetch catch us up
+    updateLoggedIn();
+    m_rewards->setRewards(m_rewardCache->load(m_userId));
+    connect(m_rewards, &RewardModel::rewardChanged, this,
+            [this]() { m_rewardCache->save(m_userId, m_rewards->rewards()); });
+
+    // pick up whatever was still in progress when we last stopped, but only
+    // once a validate confirms who we are, before that the restored session
+    // may be stale and settling anything would just fail
+    const QHash<QString, RedemptionJournal::Entry> journal = m_journal->load();
+    if (!journal.isEmpty()) {
+        connect(
+            this, &TwitchManager::validated, this,
+            [this, journal]() { resumeJournal(journal); }, Qt::SingleShotConnection);
+    }
+
+    // redemptions get pushed to us over eventsub as soon as they happen
+    connect(m_eventSub, &EventSubClient::welcomed, this, &TwitchManager::eventSubWelcomed);
+    connect(m_eventSub, &EventSubClient::redemptionAdded, this,
+            &TwitchManager::eventSubRedemption);
+}
+
+TwitchManager::~TwitchManager()
+{
+    // the scheduler may outlive us, nothing it still holds may call back
+    for (const InFlightRequest &request : qAsConst(m_requests)) {
+        if (request.ticket != 0) {
+            m_scheduler->cancel(request.ticket);
+        }
+    }
+}
+
+QString TwitchManager::dataPath(const QString &channel)
+{
+    const QString root = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return channel.isEmpty() ? root : root + u"/channels/"_qs + channel;
+}
+
+void TwitchManager::useEventSubStandIn(const QUrl &url)
+{
+    // a local stand-in doesn't know about helix, so there is nothing to
+    // subscribe to and no reason to wait for a validated session
+    qInfo() << "Using EventSub stand-in:" << url;
+    m_eventSubStandIn = true;
+    m_eventSub->close();
+    m_eventSub->setUrl(url);
+    m_eventSub->open();
+}
+
+void TwitchManager::useTwitchStandIn(const QUrl &url)
+{
+    // everything keeps its path, only where it goes changes, so one stand-in
+    // serves both the id and helix endpoints
+    qInfo() << "Using Twitch stand-in:" << url;
+    m_standInUrl = url;
+    m_scheduler->warmUp({endpoint(TokenUrl), endpoint(RewardsUrl)});
+}
+
+QUrl TwitchManager::endpoint(const QUrl &url) const
+{
+    if (m_standInUrl.isEmpty()) {
+        return url;
+    }
+    QUrl redirected(url);
+    redirected.setScheme(m_standInUrl.scheme());
+    redirected.setHost(m_standInUrl.host());
+    redirected.setPort(m_standInUrl.port());
+    return redirected;
+}
+
+bool TwitchManager::expectsCallback(const QUrl &url) const
+{
+    const QString state = QUrlQuery(url.query()).queryItemValue(u"state"_qs, QUrl::FullyDecoded);
+    return !m_expectedState.isEmpty() && m_expectedState == state;
 }
 
 void TwitchManager::handleCallback(const QUrl &url)
@@ -50,21 +170,19 @@ void TwitchManager::handleCallback(const QUrl &url)
     }
     // we only want to see our expected state once, no re-use!
     m_expectedState.clear();
+    updateBusy();
 
     const QString error = query.queryItemValue(u"error"_qs, QUrl::FullyDecoded);
     if (!error.isEmpty()) {
         qWarning() << "Login failed:" << error;
-        setLoading(false);
         return;
     }
 
-    setLoading(true);
     const QString code = query.queryItemValue(u"code"_qs, QUrl::FullyDecoded);
-    QSettings settings;
-    settings.remove(u"TwitchSession"_qs);
+    m_session->clear();
 
     qInfo() << "Sending request to authorize session...";
-    QNetworkRequest request(TokenUrl);
+    QNetworkRequest request(endpoint(TokenUrl));
     request.setHeader(QNetworkRequest::ContentTypeHeader, u"application/x-www-form-urlencoded"_qs);
     QUrlQuery formData;
     formData.addQueryItem(u"client_id"_qs, secrets::twitchClientId);
@@ -72,15 +190,12 @@ void TwitchManager::handleCallback(const QUrl &url)
     formData.addQueryItem(u"code"_qs, code);
     formData.addQueryItem(u"grant_type"_qs, u"authorization_code"_qs);
     formData.addQueryItem(u"redirect_uri"_qs, secrets::twitchRedirctUri);
-    QNetworkReply *reply = m_nam->post(request, formData.toString().toLatin1());
-    QTimer::singleShot(5000, reply, &QNetworkReply::abort); // timeout after 5 seconds
-    connect(reply, &QNetworkReply::finished, this, &TwitchManager::authorizeFinished);
+    send(Authorize, request, "POST", formData.toString().toLatin1(),
+         [this](QNetworkReply *reply) { authorizeFinished(reply); });
 }
 
-void TwitchManager::authorizeFinished()
+void TwitchManager::authorizeFinished(QNetworkReply *reply)
 {
-    QNetworkReply *reply = qobject_cast<QNetworkReply *>(QObject::sender());
-
     // early exit for major errors
     if (!reply->isOpen() || reply->error() != QNetworkReply::NoError) {
         QString message = reply->errorString();
@@ -91,7 +206,6 @@ void TwitchManager::authorizeFinished()
         }
         qWarning() << "Authorize failed:" << message;
         updateLoggedIn();
-        setLoading(false);
         return;
     }
 
@@ -103,7 +217,6 @@ void TwitchManager::authorizeFinished()
     if (accessToken.isEmpty() || refreshToken.isEmpty()) {
         qWarning() << "Authorize failed: did not recieve tokens!";
         updateLoggedIn();
-        setLoading(false);
         return;
     }
 
@@ -117,16 +230,12 @@ void TwitchManager::authorizeFinished()
             QTimer::singleShot(500, this, [&]() { login(true); });
         } else {
             updateLoggedIn();
-            setLoading(false);
         }
         return;
     }
 
     // if we reach this point then everything should be good!
-    QSettings settings;
-    settings.beginGroup(u"TwitchSession"_qs);
-    settings.setValue(u"AccessToken"_qs, accessToken);
-    settings.setValue(u"RefreshToken"_qs, refreshToken);
+    m_session->setTokens(accessToken, refreshToken, expiresAt(response));
     qInfo() << "Authorize success!";
 
     // finally, we want to do a good faith validate
@@ -136,15 +245,17 @@ void TwitchManager::authorizeFinished()
 
 void TwitchManager::validate(const bool &force)
 {
-    if (m_loading & !force) {
-        qWarning() << "Cannot validate while other actions are in progress!";
+    if (isInFlight({Authorize, Validate, Refresh}) && !force) {
+        qWarning() << "Cannot validate while other auth actions are in progress!";
+        // a validate already out answers for this one, anything else would
+        // leave whoever asked waiting
+        if (!isInFlight({Validate})) {
+            emit validateFailed();
+        }
         return;
     }
 
-    setLoading(true);
-    QSettings settings;
-    settings.beginGroup(u"TwitchSession"_qs);
-    const QString accessToken = settings.value(u"AccessToken"_qs).toString();
+    const QString accessToken = m_session->accessToken();
     if (accessToken.isEmpty()) {
         updateLoggedIn();
         if (m_autoLogin) {
@@ -152,25 +263,22 @@ void TwitchManager::validate(const bool &force)
             QTimer::singleShot(500, this, [&]() { login(); });
         } else {
             qWarning() << "Validate failed: no session!";
-            setLoading(false);
         }
+        emit validateFailed();
         return;
     } else {
         updateLoggedIn();
     }
 
     qInfo() << "Sending request to validate tokens...";
-    QNetworkRequest request(ValidateUrl);
+    QNetworkRequest request(endpoint(ValidateUrl));
     request.setRawHeader("Authorization", "Bearer " + accessToken.toLatin1());
-    QNetworkReply *reply = m_nam->get(request);
-    QTimer::singleShot(5000, reply, &QNetworkReply::abort); // timeout after 5 seconds
-    connect(reply, &QNetworkReply::finished, this, &TwitchManager::validateFinished);
+    send(Validate, request, "GET", QByteArray(),
+         [this](QNetworkReply *reply) { validateFinished(reply); });
 }
 
-void TwitchManager::validateFinished()
+void TwitchManager::validateFinished(QNetworkReply *reply)
 {
-    QNetworkReply *reply = qobject_cast<QNetworkReply *>(QObject::sender());
-
     // early exit for major errors
     if (!reply->isOpen() || reply->error() != QNetworkReply::NoError) {
         QString message = reply->errorString();
@@ -181,6 +289,7 @@ void TwitchManager::validateFinished()
         }
         qWarning() << "Validate failed:" << message;
         QTimer::singleShot(500, this, &TwitchManager::refresh);
+        emit validateFailed();
         return;
     }
 
@@ -198,38 +307,45 @@ void TwitchManager::validateFinished()
             qWarning() << "Logging out due to invalid scopes...";
             QTimer::singleShot(500, this, &TwitchManager::logout);
         }
+        emit validateFailed();
         return;
     }
 
     // if we reach this point then everything should be good!
     const QString login = response.value(u"login"_qs).toString();
     const QString userId = response.value(u"user_id"_qs).toString();
-    QSettings settings;
-    settings.beginGroup(u"TwitchSession"_qs);
-    settings.setValue(u"Login"_qs, login);
-    settings.setValue(u"UserId"_qs, userId);
+    if (userId != m_session->userId()) {
+        // rewards we have are for whoever was logged in before
+        m_rewards->setRewards({});
+    }
+    m_session->setUser(login, userId);
+    m_session->setExpiresAt(expiresAt(response));
+    m_validatedAt = QDateTime::currentDateTimeUtc();
     updateLoggedIn();
-    setLoading(false);
+    scheduleAuth();
     qInfo() << "Validate success!";
     qDebug() << "  Login:" << login;
     qDebug() << "  UserId:" << userId;
     emit validated();
+    m_eventSub->open();
 }
 
 void TwitchManager::refresh()
 {
-    setLoading(true);
-    QSettings settings;
-    settings.beginGroup(u"TwitchSession"_qs);
-    const QString accessToken = settings.value(u"AccessToken"_qs).toString();
-    const QString refreshToken = settings.value(u"RefreshToken"_qs).toString();
+    if (isInFlight({Refresh})) {
+        qDebug() << "Refresh already in progress.";
+        return;
+    }
+
+    const QString accessToken = m_session->accessToken();
+    const QString refreshToken = m_session->refreshToken();
     if (accessToken.isEmpty() || refreshToken.isEmpty()) {
+        dropParked();
         if (m_autoLogin) {
             qInfo() << "Attempting auto login...";
             QTimer::singleShot(500, this, [&]() { login(); });
         } else if (accessToken.isEmpty()) {
             qWarning() << "Refresh failed: no session!";
-            setLoading(false);
         } else {
             qWarning() << "Refresh failed: missing refresh token!";
             qWarning() << "Logging out due to missing refresh token...";
@@ -239,22 +355,19 @@ void TwitchManager::refresh()
     }
 
     qInfo() << "Sending request to refresh tokens...";
-    QNetworkRequest request(TokenUrl);
+    QNetworkRequest request(endpoint(TokenUrl));
     request.setHeader(QNetworkRequest::ContentTypeHeader, u"application/x-www-form-urlencoded"_qs);
     QUrlQuery formData;
     formData.addQueryItem(u"client_id"_qs, secrets::twitchClientId);
     formData.addQueryItem(u"client_secret"_qs, secrets::twitchClientSecret);
     formData.addQueryItem(u"grant_type"_qs, u"refresh_token"_qs);
     formData.addQueryItem(u"refresh_token"_qs, QUrl::toPercentEncoding(refreshToken));
-    QNetworkReply *reply = m_nam->post(request, formData.toString().toLatin1());
-    QTimer::singleShot(5000, reply, &QNetworkReply::abort); // timeout after 5 seconds
-    connect(reply, &QNetworkReply::finished, this, &TwitchManager::refreshFinished);
+    send(Refresh, request, "POST", formData.toString().toLatin1(),
+         [this](QNetworkReply *reply) { refreshFinished(reply); });
 }
 
-void TwitchManager::refreshFinished()
+void TwitchManager::refreshFinished(QNetworkReply *reply)
 {
-    QNetworkReply *reply = qobject_cast<QNetworkReply *>(QObject::sender());
-
     // early exit for major errors
     if (!reply->isOpen() || reply->error() != QNetworkReply::NoError) {
         QString message = reply->errorString();
@@ -264,6 +377,8 @@ void TwitchManager::refreshFinished()
             message = response.value(u"message"_qs).toString();
         }
         qWarning() << "Refresh failed:" << message;
+        dropParked();
+        emit refreshed(false);
         if (m_autoLogin) {
             qInfo() << "Attempting auto login...";
             QTimer::singleShot(500, this, [&]() { login(); });
@@ -281,6 +396,8 @@ void TwitchManager::refreshFinished()
     const QString refreshToken = response.value(u"refresh_token"_qs).toString();
     if (accessToken.isEmpty() || refreshToken.isEmpty()) {
         qWarning() << "Refresh failed: did not recieve new tokens!";
+        dropParked();
+        emit refreshed(false);
         if (m_autoLogin) {
             qInfo() << "Attempting auto login...";
             QTimer::singleShot(500, this, [&]() { login(); });
@@ -296,6 +413,8 @@ void TwitchManager::refreshFinished()
     if (!validateScopes(scopes)) {
         qWarning() << "Refresh failed: scopes do not match!";
         qWarning() << "   Scopes:" << scopes;
+        dropParked();
+        emit refreshed(false);
         if (m_autoLogin) {
             qInfo() << "Attempting auto login with forced verification...";
             QTimer::singleShot(500, this, [&]() { login(true); });
@@ -303,22 +422,28 @@ void TwitchManager::refreshFinished()
             qWarning() << "Logging out due to invalid scopes...";
             QTimer::singleShot(500, this, &TwitchManager::logout);
         }
+        emit validateFailed();
         return;
     }
 
     // if we reach this point then everything should be good!
-    QSettings settings;
-    settings.beginGroup(u"TwitchSession"_qs);
-    settings.setValue(u"AccessToken"_qs, accessToken);
-    settings.setValue(u"RefreshToken"_qs, refreshToken);
+    m_session->setTokens(accessToken, refreshToken, expiresAt(response));
     updateLoggedIn();
-    setLoading(false);
+    scheduleAuth();
     qInfo() << "Refresh success!";
+    emit refreshed(true);
+    replayParked();
+}
+
+void TwitchManager::save()
+{
+    m_session->flush();
+    m_rewardCache->flush();
+    m_journal->flush();
 }
 
 void TwitchManager::login(const bool &forceVerify)
 {
-    setLoading(true);
     QUrlQuery query;
     query.addQueryItem(u"client_id"_qs, secrets::twitchClientId);
     query.addQueryItem(u"redirect_uri"_qs, secrets::twitchRedirctUri);
@@ -335,64 +460,285 @@ void TwitchManager::login(const bool &forceVerify)
     // state is an optional random string that will be returned for us to verify
     m_expectedState = QUuid::createUuid().toString(QUuid::WithoutBraces);
     query.addQueryItem(u"state"_qs, m_expectedState);
+    updateBusy();
 
-    QUrl url(AuthorizeUrl);
+    QUrl url(endpoint(AuthorizeUrl));
     url.setQuery(query);
+#ifdef CHAP_HEADLESS
+    // nothing to open a browser with, whoever is watching the log has to
+    // open it and hand the callback url back to us
+    qInfo().noquote() << "Open this url to log in:" << url.toString(QUrl::FullyEncoded);
+    qInfo() << "Then pass the chap:// url you get redirected to along to chapd.";
+#else
     QDesktopServices::openUrl(url);
+#endif
 }
 
 void TwitchManager::logout()
 {
     if (!m_loggedIn) {
         qDebug() << "Can't log out if we aren't signed in!";
-        setLoading(false);
         return;
     }
 
-    setLoading(true);
-    QSettings settings;
-    settings.beginGroup(u"TwitchSession"_qs);
-    const QString accessToken = settings.value(u"AccessToken"_qs).toString();
-    settings.endGroup();
-    settings.remove(u"TwitchSession"_qs);
+    if (!m_eventSubStandIn) {
+        m_eventSub->close();
+    }
+    // anything still outstanding is pointless once the session is gone
+    for (const quint64 &id : m_requests.keys()) {
+        cancel(id);
+    }
+    // the cancelled syncs have been told, the marks belong to the old session
+    m_syncs.clear();
+    const QString accessToken = m_session->accessToken();
+    m_session->clear();
+    m_authTimer->stop();
+    m_validatedAt = QDateTime();
+    m_rewards->setRewards({});
+    m_rewardCache->clear();
     if (accessToken.isEmpty()) {
         qInfo() << "Logged out.";
         updateLoggedIn();
-        setLoading(false);
         return;
     }
 
     qInfo() << "Sending request to revoke tokens...";
-    QNetworkRequest request(RevokeUrl);
+    QNetworkRequest request(endpoint(RevokeUrl));
     request.setHeader(QNetworkRequest::ContentTypeHeader, u"application/x-www-form-urlencoded"_qs);
     QUrlQuery formData;
     formData.addQueryItem(u"client_id"_qs, secrets::twitchClientId);
     formData.addQueryItem(u"token"_qs, accessToken);
-    QNetworkReply *reply = m_nam->post(request, formData.toString().toLatin1());
-    QTimer::singleShot(5000, reply, &QNetworkReply::abort); // timeout after 5 seconds
-    connect(reply, &QNetworkReply::finished, this, &TwitchManager::logoutFinished);
+    send(Revoke, request, "POST", formData.toString().toLatin1(),
+         [this](QNetworkReply *reply) { logoutFinished(reply); });
 }
 
-void TwitchManager::logoutFinished()
+void TwitchManager::logoutFinished(QNetworkReply *)
 {
     // errors don't really matter here since we can't really do anything else
     // other than tell the user and we already removed any session records
     // when the logout was requested
     qInfo() << "Revoke success!";
     updateLoggedIn();
-    setLoading(false);
 }
 
 void TwitchManager::updateLoggedIn()
 {
-    QSettings settings;
-    settings.beginGroup(u"TwitchSession"_qs);
-    m_accessToken = settings.value(u"AccessToken"_qs).toString();
-    m_userId = settings.value(u"UserId"_qs).toString();
-    setUserName(settings.value(u"Login"_qs).toString());
+    m_accessToken = m_session->accessToken();
+    m_userId = m_session->userId();
+    setUserName(m_session->login());
     setLoggedIn(!m_accessToken.isEmpty() && !m_userId.isEmpty() && !m_userName.isEmpty());
 }
 
+QDateTime TwitchManager::expiresAt(const QJsonObject &response)
+{
+    // both token and validate responses say how many seconds are left
+    if (!response.contains(u"expires_in"_qs)) {
+        return QDateTime();
+    }
+    const qint64 expiresIn = response.value(u"expires_in"_qs).toInteger();
+    return QDateTime::currentDateTimeUtc().addSecs(expiresIn);
+}
+
+QDateTime TwitchManager::refreshAt() const
+{
+    const QDateTime expires = m_session->expiresAt();
+    if (!expires.isValid()) {
+        return QDateTime();
+    }
+    return expires.addSecs(-RefreshLead - m_session->refreshJitter());
+}
+
+void TwitchManager::scheduleAuth()
+{
+    if (!m_loggedIn) {
+        m_authTimer->stop();
+        return;
+    }
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    QDateTime next = m_validatedAt.isValid() ? m_validatedAt.addSecs(ValidateInterval) : now;
+    const QDateTime due = refreshAt();
+    if (due.isValid() && due < next) {
+        next = due;
+    }
+    const qint64 wait = qBound<qint64>(0, now.msecsTo(next), ValidateInterval * 1000);
+    qDebug() << "Next auth check in" << wait / 1000 << "seconds";
+    m_authTimer->start(static_cast<int>(wait));
+}
+
+void TwitchManager::authTimeout()
+{
+    const QDateTime due = refreshAt();
+    if (due.isValid() && QDateTime::currentDateTimeUtc() >= due) {
+        qInfo() << "Access token expiring soon, refreshing...";
+        refresh();
+    } else {
+        validate();
+    }
+}
+
+HelixScheduler::Priority TwitchManager::priority(const RequestKind &kind)
+{
+    switch (kind) {
+    case Authorize:
+    case Validate:
+    case Refresh:
+    case Revoke:
+        return HelixScheduler::Auth;
+    case UpdateRedemptions:
+        return HelixScheduler::Fulfillment;
+    case GetRedemptions:
+    case Subscribe:
+        return HelixScheduler::Redemptions;
+    default:
+        return HelixScheduler::Rewards;
+    }
+}
+
+quint64 TwitchManager::send(const RequestKind &kind, const QNetworkRequest &request,
+                            const QByteArray &verb, const QByteArray &body,
+                            HelixScheduler::Handler handler, std::function<void()> abandoned)
+{
+    // the auth timer should have refreshed well before now, but it can run
+    // late (sleep, a stalled event loop) so don't wait on it if it did
+    const QDateTime expires = m_session->expiresAt();
+    if (priority(kind) != HelixScheduler::Auth && expires.isValid() &&
+        QDateTime::currentDateTimeUtc().secsTo(expires) < ExpiryMargin &&
+        !isInFlight({Refresh})) {
+        qInfo() << "Access token about to expire, refreshing now.";
+        m_authTimer->start(0);
+    }
+
+    const quint64 id = m_nextRequestId++;
+    InFlightRequest &inFlight = m_requests[id];
+    inFlight.id = id;
+    inFlight.kind = kind;
+    inFlight.started.start();
+    inFlight.request = request;
+    inFlight.verb = verb;
+    inFlight.body = body;
+    inFlight.handler = std::move(handler);
+    inFlight.abandoned = std::move(abandoned);
+    dispatch(id);
+    updateBusy();
+    return id;
+}
+
+void TwitchManager::dispatch(const quint64 &id)
+{
+    InFlightRequest &inFlight = m_requests[id];
+    inFlight.parked = false;
+    inFlight.request.setAttribute(HelixScheduler::BucketAttribute, m_channel);
+    inFlight.ticket =
+        m_scheduler->send(priority(inFlight.kind), inFlight.request, inFlight.verb, inFlight.body,
+                          [this, id](QNetworkReply *reply) { finished(id, reply); });
+}
+
+void TwitchManager::finished(const quint64 &id, QNetworkReply *reply)
+{
+    auto iter = m_requests.find(id);
+    if (iter == m_requests.end()) {
+        return;
+    }
+
+    // a 401 on a helix request means the token went bad under us, so the
+    // request waits for fresh tokens and goes out again instead of being lost
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 401 && priority(iter->kind) != HelixScheduler::Auth &&
+        iter->authRetries < MaxAuthRetries) {
+        iter->authRetries++;
+        // if a refresh already landed while this was out, just send it again
+        const QByteArray authorization = "Bearer " + m_accessToken.toLatin1();
+        if (iter->request.rawHeader("Authorization") != authorization) {
+            qInfo() << iter->kind << "request" << id << "used old tokens, replaying";
+            iter->request.setRawHeader("Authorization", authorization);
+            dispatch(id);
+            return;
+        }
+        iter->parked = true;
+        iter->ticket = 0;
+        qWarning() << iter->kind << "request" << id << "not authorized, parked for refresh";
+        // every parked request shares the one refresh, refresh() won't
+        // send another while one is already out
+        refresh();
+        return;
+    }
+
+    const InFlightRequest inFlight = m_requests.take(id);
+    qDebug() << inFlight.kind << "finished in" << inFlight.started.elapsed() << "ms";
+    updateBusy();
+    inFlight.handler(reply);
+}
+
+void TwitchManager::replayParked()
+{
+    for (auto iter = m_requests.begin(); iter != m_requests.end(); ++iter) {
+        if (!iter->parked) {
+            continue;
+        }
+        qDebug() << "Replaying" << iter->kind << "request" << iter->id;
+        iter->request.setRawHeader("Authorization", "Bearer " + m_accessToken.toLatin1());
+        dispatch(iter->id);
+    }
+}
+
+void TwitchManager::dropParked()
+{
+    QList<std::function<void()>> abandoned;
+    for (auto iter = m_requests.begin(); iter != m_requests.end();) {
+        if (!iter->parked) {
+            ++iter;
+            continue;
+        }
+        qWarning() << "Dropping" << iter->kind << "request" << iter->id << "without tokens";
+        if (iter->abandoned) {
+            abandoned.append(iter->abandoned);
+        }
+        iter = m_requests.erase(iter);
+    }
+    updateBusy();
+    // only once we're done with m_requests, they can send more requests
+    for (const auto &finish : qAsConst(abandoned)) {
+        finish();
+    }
+}
+
+void TwitchManager::cancel(const quint64 &id)
+{
+    if (!m_requests.contains(id)) {
+        return;
+    }
+    const InFlightRequest inFlight = m_requests.take(id);
+    qDebug() << "Cancelling" << inFlight.kind << "request" << id;
+    m_scheduler->cancel(inFlight.ticket);
+    updateBusy();
+    if (inFlight.abandoned) {
+        inFlight.abandoned();
+    }
+}
+
+bool TwitchManager::isInFlight(const QList<RequestKind> &kinds) const
+{
+    for (const InFlightRequest &inFlight : m_requests) {
+        if (kinds.contains(inFlight.kind)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TwitchManager::updateBusy()
+{
+    // waiting on the browser for a login callback counts as authorizing too
+    setInFlight(m_requests.size());
+    setAuthorizing(!m_expectedState.isEmpty() ||
+                   isInFlight({Authorize, Validate, Refresh, Revoke}));
+    setFetchingRewards(isInFlight({GetRewards}));
+    setUpdatingRewards(isInFlight({CreateReward, UpdateReward}));
+    setFetchingRedemptions(isInFlight({GetRedemptions, Subscribe}));
+    setUpdatingRedemptions(isInFlight({UpdateRedemptions}));
+    setLoading(m_inFlight > 0 || m_authorizing);
+}
+
 bool TwitchManager::validateScopes(const QJsonArray &scopes) const
 {
     QList<QString> expectedScopes(Scopes);
@@ -432,36 +778,42 @@ void TwitchManager::getRewards()
     //   only_manageable_rewards to filter for rewards our client-id can manage
     if (!m_loggedIn) {
         qWarning() << "Cannot get rewards without being logged in!";
+        emit rewardsFailed();
+        return;
+    }
+    // startup and validate both ask for them, one answer does for both
+    if (isInFlight({GetRewards})) {
+        qDebug() << "Rewards already being fetched.";
         return;
     }
 
-    setLoading(true);
     QUrlQuery query;
     query.addQueryItem(u"broadcaster_id"_qs, m_userId);
-    QUrl url(RewardsUrl);
+    QUrl url(endpoint(RewardsUrl));
     url.setQuery(query);
     auto request = createRequest(url);
-    QNetworkReply *reply = m_nam->get(request);
-    QTimer::singleShot(5000, reply, &QNetworkReply::abort); // timeout after 5 seconds
-    connect(reply, &QNetworkReply::finished, this, &TwitchManager::getRewardsFinished);
+    send(
+        GetRewards, request, "GET", QByteArray(),
+        [this](QNetworkReply *reply) { getRewardsFinished(reply); },
+        [this]() { emit rewardsFailed(); });
 }
 
-void TwitchManager::getRewardsFinished()
+void TwitchManager::getRewardsFinished(QNetworkReply *reply)
 {
     // https://dev.twitch.tv/docs/api/reference/#get-custom-reward
-    QNetworkReply *reply = qobject_cast<QNetworkReply *>(QObject::sender());
     const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
     switch (status) {
     case 200: {
         if (reply->isOpen()) {
-            QJsonObject response = QJsonDocument::fromJson(reply->readAll()).object();
-            QJsonArray rewards = response.value(u"data"_qs).toArray();
-            qInfo() << "Got rewards:" << rewards.count();
-            m_rewards.clear();
-            for (auto value : rewards) {
-                m_rewards.append(value.toObject().toVariantMap());
+            QList<Reward> rewards;
+            if (!HelixParser::parseRewards(reply->readAll(), rewards)) {
+                qWarning() << "Get Rewards Failed: Could not parse reply!";
+                break;
             }
-            emit rewardsChanged(m_rewards);
+            qInfo() << "Got rewards:" << rewards.count();
+            m_rewards->setRewards(rewards);
+            emit gotRewards();
+            return;
         } else {
             qWarning() << "Get Rewards Failed: Could not read reply!";
         }
@@ -473,8 +825,7 @@ void TwitchManager::getRewardsFinished()
     }
     case 401: {
         qWarning() << "Get Rewards Failed: Not authorized!";
-        QTimer::singleShot(500, this, &TwitchManager::refresh);
-        return; // intentional, we don't want to go loading = false
+        break;
     }
     case 403: {
         qWarning() << "Get Rewards Failed: Broadcast not partner or affiliate!";
@@ -489,7 +840,7 @@ void TwitchManager::getRewardsFinished()
         break;
     }
     }
-    setLoading(false);
+    emit rewardsFailed();
 }
 
 void TwitchManager::createReward(const QVariantMap &data)
@@ -500,29 +851,31 @@ void TwitchManager::createReward(const QVariantMap &data)
         return;
     }
 
-    setLoading(true);
     QUrlQuery query;
     query.addQueryItem(u"broadcaster_id"_qs, m_userId);
-    QUrl url(RewardsUrl);
+    QUrl url(endpoint(RewardsUrl));
     url.setQuery(query);
     auto request = createRequest(url);
     request.setHeader(QNetworkRequest::ContentTypeHeader, u"application/json"_qs);
-    QNetworkReply *reply = m_nam->post(
-        request, QJsonDocument(QJsonObject::fromVariantMap(data)).toJson(QJsonDocument::Compact));
-    QTimer::singleShot(5000, reply, &QNetworkReply::abort); // timeout after 5 seconds
-    connect(reply, &QNetworkReply::finished, this, &TwitchManager::createRewardFinished);
+    send(CreateReward, request, "POST",
+         QJsonDocument(QJsonObject::fromVariantMap(data)).toJson(QJsonDocument::Compact),
+         [this](QNetworkReply *reply) { createRewardFinished(reply); });
 }
 
-void TwitchManager::createRewardFinished()
+void TwitchManager::createRewardFinished(QNetworkReply *reply)
 {
     // see https://dev.twitch.tv/docs/api/reference/#create-custom-rewards
-    QNetworkReply *reply = qobject_cast<QNetworkReply *>(QObject::sender());
     const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
     switch (status) {
     case 200: {
+        // twitch hands back the new reward, no need to fetch them all again
+        QList<Reward> rewards;
+        HelixParser::parseRewards(reply->readAll(), rewards);
+        for (const Reward &reward : qAsConst(rewards)) {
+            m_rewards->upsert(reward);
+        }
         qInfo() << "Reward created!";
-        QTimer::singleShot(500, this, &TwitchManager::getRewards);
-        return; // intentional, we don't want to go loading = false
+        return;
     }
     case 400: {
         qWarning() << "Create Reward Failed: Invalid parameters!";
@@ -530,8 +883,7 @@ void TwitchManager::createRewardFinished()
     }
     case 401: {
         qWarning() << "Create Reward Failed: Not authorized!";
-        QTimer::singleShot(500, this, &TwitchManager::refresh);
-        return; // intentional, we don't want to go loading = false
+        return;
     }
     case 403: {
         qWarning() << "Create Reward Failed: Broadcast not partner or affiliate!";
@@ -542,7 +894,6 @@ void TwitchManager::createRewardFinished()
         break;
     }
     }
-    setLoading(false);
 }
 
 void TwitchManager::updateReward(const QVariantMap &data)
@@ -560,30 +911,30 @@ void TwitchManager::updateReward(const QVariantMap &data)
         return;
     }
 
-    setLoading(true);
     QUrlQuery query;
     query.addQueryItem(u"broadcaster_id"_qs, m_userId);
     query.addQueryItem(u"id"_qs, id);
-    QUrl url(RewardsUrl);
+    QUrl url(endpoint(RewardsUrl));
     url.setQuery(query);
     auto request = createRequest(url);
     request.setHeader(QNetworkRequest::ContentTypeHeader, u"application/json"_qs);
-    QNetworkReply *reply = m_nam->sendCustomRequest(
-        request, "PATCH", QJsonDocument(reward).toJson(QJsonDocument::Compact));
-    QTimer::singleShot(5000, reply, &QNetworkReply::abort); // timeout after 5 seconds
-    connect(reply, &QNetworkReply::finished, this, &TwitchManager::updateRewardFinished);
+    send(UpdateReward, request, "PATCH", QJsonDocument(reward).toJson(QJsonDocument::Compact),
+         [this](QNetworkReply *reply) { updateRewardFinished(reply); });
 }
 
-void TwitchManager::updateRewardFinished()
+void TwitchManager::updateRewardFinished(QNetworkReply *reply)
 {
     // see https://dev.twitch.tv/docs/api/reference/#create-custom-rewards
-    QNetworkReply *reply = qobject_cast<QNetworkReply *>(QObject::sender());
     const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
     switch (status) {
     case 200: {
+        QList<Reward> rewards;
+        HelixParser::parseRewards(reply->readAll(), rewards);
+        for (const Reward &reward : qAsConst(rewards)) {
+            m_rewards->upsert(reward);
+        }
         qInfo() << "Reward updated!";
-        QTimer::singleShot(500, this, &TwitchManager::getRewards);
-        return; // intentional, we don't want to go loading = false
+        return;
     }
     case 400: {
         qWarning() << "Update Reward Failed: Invalid parameters!";
@@ -591,8 +942,7 @@ void TwitchManager::updateRewardFinished()
     }
     case 401: {
         qWarning() << "Update Reward Failed: Not authorized!";
-        QTimer::singleShot(500, this, &TwitchManager::refresh);
-        return; // intentional, we don't want to go loading = false
+        return;
     }
     case 403: {
         qWarning() << "Update Reward Failed: Broadcast not partner or affiliate!";
@@ -603,7 +953,6 @@ void TwitchManager::updateRewardFinished()
         break;
     }
     }
-    setLoading(false);
 }
 
 void TwitchManager::getRedemptions(const QVariantMap &params)
@@ -622,36 +971,34 @@ void TwitchManager::getRedemptions(const QVariantMap &params)
         return;
     }
 
-    setLoading(true);
     QUrlQuery query;
     query.addQueryItem(u"broadcaster_id"_qs, m_userId);
     for (auto iter = params.cbegin(); iter != params.cend(); ++iter) {
         query.addQueryItem(iter.key(), iter.value().toString());
     }
-    QUrl url(RedemptionsUrl);
+    QUrl url(endpoint(RedemptionsUrl));
     url.setQuery(query);
     auto request = createRequest(url);
-    QNetworkReply *reply = m_nam->get(request);
-    QTimer::singleShot(5000, reply, &QNetworkReply::abort); // timeout after 5 seconds
-    connect(reply, &QNetworkReply::finished, this, &TwitchManager::getRedemptionsFinished);
+    send(GetRedemptions, request, "GET", QByteArray(),
+         [this](QNetworkReply *reply) { getRedemptionsFinished(reply); });
 }
 
-void TwitchManager::getRedemptionsFinished()
+void TwitchManager::getRedemptionsFinished(QNetworkReply *reply)
 {
     // see https://dev.twitch.tv/docs/api/reference/#get-custom-reward-redemption
-    QNetworkReply *reply = qobject_cast<QNetworkReply *>(QObject::sender());
     const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
     switch (status) {
     case 200: {
         if (reply->isOpen()) {
-            QJsonObject response = QJsonDocument::fromJson(reply->readAll()).object();
-            QJsonArray objs = response.value(u"data"_qs).toArray();
-            qInfo() << "Got redemptions:" << objs.count();
-            QList<QVariantMap> redemptions;
-            for (auto value : objs) {
-                redemptions.append(value.toObject().toVariantMap());
+            const qint64 fetchedAt = steadyMicros();
+            QList<Redemption> parsed;
+            if (!HelixParser::parseRedemptions(reply->readAll(), parsed)) {
+                qWarning() << "Get Redemptions Failed: Could not parse reply!";
+                break;
             }
-            emit gotRedemptions(redemptions);
+            stamp(parsed, fetchedAt);
+            qInfo() << "Got redemptions:" << parsed.count();
+            handOut(parsed);
         } else {
             qWarning() << "Get Redemptions Failed: Could not read reply!";
         }
@@ -663,8 +1010,7 @@ void TwitchManager::getRedemptionsFinished()
     }
     case 401: {
         qWarning() << "Get Redemptions Failed: Not authorized!";
-        QTimer::singleShot(500, this, &TwitchManager::refresh);
-        return; // intentional, we don't want to go loading = false
+        return;
     }
     case 403: {
         qWarning() << "Get Redemptions Failed: Broadcast not partner or affiliate!";
@@ -675,7 +1021,136 @@ void TwitchManager::getRedemptionsFinished()
         break;
     }
     }
-    setLoading(false);
+}
+
+void TwitchManager::syncRedemptions(const QString &rewardId)
+{
+    // see https://dev.twitch.tv/docs/api/reference/#get-custom-reward-redemption
+    // walks the unfulfilled backlog newest first, a page at a time, until it
+    // reaches the newest redemption a previous sync already handed out
+    if (!m_loggedIn) {
+        qWarning() << "Cannot sync redemptions without being logged in!";
+        return;
+    }
+    if (rewardId.isEmpty()) {
+        qWarning() << "Cannot sync redemptions without a reward id!";
+        return;
+    }
+
+    RedemptionSync &sync = m_syncs[rewardId];
+    if (sync.running) {
+        qDebug() << "Redemption sync already running for:" << rewardId;
+        return;
+    }
+    sync.running = true;
+    sync.pages = 0;
+    sync.nextMarkId.clear();
+    sync.nextMarkAt = QDateTime();
+    requestRedemptionPage(rewardId, QString());
+}
+
+void TwitchManager::requestRedemptionPage(const QString &rewardId, const QString &cursor)
+{
+    QUrlQuery query;
+    query.addQueryItem(u"broadcaster_id"_qs, m_userId);
+    query.addQueryItem(u"reward_id"_qs, rewardId);
+    query.addQueryItem(u"status"_qs, u"UNFULFILLED"_qs);
+    query.addQueryItem(u"sort"_qs, u"NEWEST"_qs);
+    query.addQueryItem(u"first"_qs, QString::number(RedemptionPageSize));
+    if (!cursor.isEmpty()) {
+        query.addQueryItem(u"after"_qs, cursor);
+    }
+    QUrl url(endpoint(RedemptionsUrl));
+    url.setQuery(query);
+    auto request = createRequest(url);
+    send(
+        GetRedemptions, request, "GET", QByteArray(),
+        [this, rewardId](QNetworkReply *reply) { syncRedemptionsFinished(reply, rewardId); },
+        [this, rewardId]() { finishSync(rewardId, false); });
+}
+
+void TwitchManager::syncRedemptionsFinished(QNetworkReply *reply, const QString &rewardId)
+{
+    // see https://dev.twitch.tv/docs/api/reference/#get-custom-reward-redemption
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    switch (status) {
+    case 200: {
+        if (!reply->isOpen()) {
+            qWarning() << "Sync Redemptions Failed: Could not read reply!";
+            break;
+        }
+        const qint64 fetchedAt = steadyMicros();
+        QList<Redemption> parsed;
+        QString cursor;
+        if (!HelixParser::parseRedemptions(reply->readAll(), parsed, &cursor)) {
+            qWarning() << "Sync Redemptions Failed: Could not parse reply!";
+            break;
+        }
+        stamp(parsed, fetchedAt);
+        RedemptionSync &sync = m_syncs[rewardId];
+        sync.pages++;
+        QList<Redemption> redemptions;
+        bool reachedMark = false;
+        for (const Redemption &redemption : qAsConst(parsed)) {
+            if (redemption.id == sync.markId ||
+                (sync.markAt.isValid() && redemption.redeemedAt < sync.markAt)) {
+                reachedMark = true;
+                break;
+            }
+            // pages are newest first, so the very first one is our next mark
+            if (sync.nextMarkId.isEmpty()) {
+                sync.nextMarkId = redemption.id;
+                sync.nextMarkAt = redemption.redeemedAt;
+            }
+            redemptions.append(redemption);
+        }
+        qInfo() << "Synced redemptions:" << redemptions.count() << "page" << sync.pages;
+        handOut(redemptions);
+
+        if (reachedMark || cursor.isEmpty()) {
+            finishSync(rewardId, true);
+            return;
+        }
+        if (sync.pages < MaxSyncPages) {
+            requestRedemptionPage(rewardId, cursor);
+            return;
+        }
+        // there is more backlog than we walk in one go, leave the mark where
+        // it was so the next sync goes over the pages we didn't get to
+        qWarning() << "Sync Redemptions stopped after" << sync.pages << "pages";
+        finishSync(rewardId, false);
+        return;
+    }
+    case 400: {
+        qWarning() << "Sync Redemptions Failed: Invalid parameters!";
+        break;
+    }
+    case 401: {
+        qWarning() << "Sync Redemptions Failed: Not authorized!";
+        break;
+    }
+    case 403: {
+        qWarning() << "Sync Redemptions Failed: Broadcast not partner or affiliate!";
+        break;
+    }
+    default: {
+        qWarning() << "Sync Redemptions Failed: Unknown error" << status;
+        break;
+    }
+    }
+    finishSync(rewardId, false);
+}
+
+void TwitchManager::finishSync(const QString &rewardId, const bool &success)
+{
+    RedemptionSync &sync = m_syncs[rewardId];
+    sync.running = false;
+    // only move the mark once the whole backlog made it through, otherwise
+    // the next sync would stop before reaching the pages we missed
+    if (success && !sync.nextMarkId.isEmpty()) {
+        sync.markId = sync.nextMarkId;
+        sync.markAt = sync.nextMarkAt;
+    }
 }
 
 void TwitchManager::updateRedemption(const QString &rewardId, const QString &id,
@@ -691,30 +1166,102 @@ void TwitchManager::updateRedemption(const QString &rewardId, const QString &id,
         return;
     }
 
-    setLoading(true);
+    sendRedemptionUpdate(rewardId, {id}, status);
+}
+
+void TwitchManager::queueRedemptionUpdate(const QString &rewardId, const QString &id,
+                                          const QString &status)
+{
+    if (id.isEmpty() || rewardId.isEmpty()) {
+        qWarning() << "Cannot queue redemption update without an id or reward id!";
+        return;
+    }
+
+    QList<QString> &ids = m_pendingUpdates[{rewardId, status}];
+    if (ids.contains(id)) {
+        return;
+    }
+    ids.append(id);
+    // a full batch can go out right away, otherwise wait for the window
+    if (ids.size() >= MaxRedemptionIds) {
+        flushRedemptionUpdates();
+    } else if (!m_updateTimer->isActive()) {
+        m_updateTimer->start();
+    }
+}
+
+void TwitchManager::flushRedemptionUpdates()
+{
+    m_updateTimer->stop();
+    if (m_pendingUpdates.isEmpty()) {
+        return;
+    }
+
+    const auto pending = std::exchange(m_pendingUpdates, {});
+    if (!m_loggedIn) {
+        qWarning() << "Cannot update redemptions without being logged in!";
+        for (auto iter = pending.cbegin(); iter != pending.cend(); ++iter) {
+            for (const QString &id : iter.value()) {
+                emit redemptionUpdated(iter.key().first, id, iter.key().second, false);
+            }
+        }
+        return;
+    }
+
+    for (auto iter = pending.cbegin(); iter != pending.cend(); ++iter) {
+        const QList<QString> &ids = iter.value();
+        for (qsizetype i = 0; i < ids.size(); i += MaxRedemptionIds) {
+            sendRedemptionUpdate(iter.key().first, ids.mid(i, MaxRedemptionIds),
+                                 iter.key().second);
+        }
+    }
+}
+
+void TwitchManager::sendRedemptionUpdate(const QString &rewardId, const QList<QString> &ids,
+                                         const QString &status)
+{
+    // see https://dev.twitch.tv/docs/api/reference/#update-redemption-status
     QUrlQuery query;
     query.addQueryItem(u"broadcaster_id"_qs, m_userId);
-    query.addQueryItem(u"id"_qs, id);
     query.addQueryItem(u"reward_id"_qs, rewardId);
-    QUrl url(RedemptionsUrl);
+    for (const QString &id : ids) {
+        query.addQueryItem(u"id"_qs, id);
+    }
+    QUrl url(endpoint(RedemptionsUrl));
     url.setQuery(query);
     auto request = createRequest(url);
     request.setHeader(QNetworkRequest::ContentTypeHeader, u"application/json"_qs);
-    QNetworkReply *reply = m_nam->sendCustomRequest(
-        request, "PATCH",
-        QJsonDocument(QJsonObject{{u"status"_qs, status}}).toJson(QJsonDocument::Compact));
-    QTimer::singleShot(5000, reply, &QNetworkReply::abort); // timeout after 5 seconds
-    connect(reply, &QNetworkReply::finished, this, &TwitchManager::updateRedemptionFinished);
+    send(UpdateRedemptions, request, "PATCH",
+         QJsonDocument(QJsonObject{{u"status"_qs, status}}).toJson(QJsonDocument::Compact),
+         [this, rewardId, ids, status](QNetworkReply *reply) {
+             updateRedemptionFinished(reply, rewardId, ids, status);
+         },
+         [this, rewardId, ids, status]() {
+             for (const QString &id : ids) {
+                 emit redemptionUpdated(rewardId, id, status, false);
+             }
+         });
 }
 
-void TwitchManager::updateRedemptionFinished()
+void TwitchManager::updateRedemptionFinished(QNetworkReply *reply, const QString &rewardId,
+                                             const QList<QString> &ids,
+                                             const QString &newStatus)
 {
     // see https://dev.twitch.tv/docs/api/reference/#update-redemption-status
-    QNetworkReply *reply = qobject_cast<QNetworkReply *>(QObject::sender());
+    // twitch only returns the redemptions it actually updated
+    QSet<QString> updated;
     const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
     switch (status) {
     case 200: {
-        qInfo() << "Redemption updated!";
+        if (reply->isOpen()) {
+            QJsonObject response = QJsonDocument::fromJson(reply->readAll()).object();
+            for (auto value : response.value(u"data"_qs).toArray()) {
+                updated.insert(value.toObject().value(u"id"_qs).toString());
+            }
+            qInfo() << "Redemptions updated:" << updated.size() << "of" << ids.size();
+        } else {
+            qWarning() << "Update Redemption Failed: Could not read reply!";
+        }
         break;
     }
     case 400: {
@@ -723,8 +1270,7 @@ void TwitchManager::updateRedemptionFinished()
     }
     case 401: {
         qWarning() << "Update Redemption Failed: Not authorized!";
-        QTimer::singleShot(500, this, &TwitchManager::refresh);
-        return; // intentional, we don't want to go loading = false
+        break;
     }
     case 403: {
         qWarning() << "Update Redemption Failed: Broadcast not partner or affiliate!";
@@ -735,9 +1281,202 @@ void TwitchManager::updateRedemptionFinished()
         break;
     }
     default: {
-        qWarning() << "Update Reward Failed: Unknown error" << status;
+        qWarning() << "Update Redemption Failed: Unknown error" << status;
         break;
     }
     }
-    setLoading(false);
+    const RedemptionJournal::State state = newStatus == u"CANCELED"_qs
+                                               ? RedemptionJournal::Canceled
+                                               : RedemptionJournal::Fulfilled;
+    for (const QString &id : ids) {
+        if (updated.contains(id)) {
+            m_journal->record(rewardId, id, state);
+        }
+        emit redemptionUpdated(rewardId, id, newStatus, updated.contains(id));
+    }
+}
+
+void TwitchManager::eventSubWelcomed(const QString &sessionId, bool handover)
+{
+    // see https://dev.twitch.tv/docs/eventsub/handling-websocket-events/
+    // subscriptions move with the session on a handover, and a stand-in
+    // just sends us notifications without any subscriptions
+    if (handover || m_eventSubStandIn) {
+        return;
+    }
+    if (!m_loggedIn) {
+        qWarning() << "Cannot subscribe to redemptions without being logged in!";
+        return;
+    }
+
+    // see https://dev.twitch.tv/docs/api/reference/#create-eventsub-subscription
+    // websocket sessions must create their subscriptions within 10 seconds
+    QJsonObject body{
+        {u"type"_qs, EventSubClient::RedemptionAddType},
+        {u"version"_qs, u"1"_qs},
+        {u"condition"_qs, QJsonObject{{u"broadcaster_user_id"_qs, m_userId}}},
+        {u"transport"_qs,
+         QJsonObject{{u"method"_qs, u"websocket"_qs}, {u"session_id"_qs, sessionId}}},
+    };
+    auto request = createRequest(endpoint(SubscriptionsUrl));
+    request.setHeader(QNetworkRequest::ContentTypeHeader, u"application/json"_qs);
+    send(Subscribe, request, "POST", QJsonDocument(body).toJson(QJsonDocument::Compact),
+         [this](QNetworkReply *reply) { subscribeFinished(reply); });
+}
+
+void TwitchManager::subscribeFinished(QNetworkReply *reply)
+{
+    // see https://dev.twitch.tv/docs/api/reference/#create-eventsub-subscription
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    switch (status) {
+    case 202: {
+        qInfo() << "Subscribed to redemptions!";
+        break;
+    }
+    case 400: {
+        qWarning() << "Subscribe Failed: Invalid parameters!";
+        break;
+    }
+    case 401: {
+        qWarning() << "Subscribe Failed: Not authorized!";
+        break;
+    }
+    case 403: {
+        qWarning() << "Subscribe Failed: Missing required scope!";
+        break;
+    }
+    case 409: {
+        qInfo() << "Already subscribed to redemptions.";
+        break;
+    }
+    case 429: {
+        qWarning() << "Subscribe Failed: Too many subscriptions!";
+        break;
+    }
+    default: {
+        qWarning() << "Subscribe Failed: Unknown error" << status;
+        break;
+    }
+    }
+}
+
+void TwitchManager::eventSubRedemption(const QJsonObject &event)
+{
+    // see https://dev.twitch.tv/docs/eventsub/eventsub-reference/#channel-points-custom-reward-redemption-add-event
+    // events are shaped like helix redemptions other than the broadcaster
+    // field names and a lowercase status, which Redemption smooths over
+    const qint64 fetchedAt = steadyMicros();
+    Redemption redemption = Redemption::fromJson(event);
+    redemption.fetchedAt = fetchedAt;
+    redemption.parsedAt = steadyMicros();
+
+    // rewards that skip the request queue arrive already fulfilled
+    if (redemption.status != u"UNFULFILLED"_qs) {
+        qDebug() << "Ignoring redemption event with status:" << redemption.status;
+        return;
+    }
+    qInfo() << "Got redemption event:" << redemption.id;
+    handOut({redemption});
+}
+
+void TwitchManager::rewardChanged(const QString &)
+{
+    // both lookups are hashed and the setters only notify on a real change,
+    // so bindings on a device reward don't fire for unrelated rewards
+    const Reward *shock = m_rewards->byTitle(ShockRewardTitle);
+    const Reward *smoke = m_rewards->byTitle(SmokeRewardTitle);
+    setShockReward(shock ? QVariant::fromValue(*shock) : QVariant());
+    setSmokeReward(smoke ? QVariant::fromValue(*smoke) : QVariant());
+}
+
+void TwitchManager::stamp(QList<Redemption> &redemptions, const qint64 &fetchedAt)
+{
+    const qint64 parsedAt = steadyMicros();
+    for (Redemption &redemption : redemptions) {
+        redemption.fetchedAt = fetchedAt;
+        redemption.parsedAt = parsedAt;
+    }
+}
+
+void TwitchManager::handOut(const QList<Redemption> &redemptions)
+{
+    // the same redemption can come from eventsub and any number of polls
+    // until it's fulfilled, each one only gets to trigger something once,
+    // but it only counts as seen once something claims it, one nobody had a
+    // rule for yet gets another go on the next poll
+    QList<Redemption> unseen;
+    for (const Redemption &redemption : redemptions) {
+        if (m_seen.contains(redemption.id) ||
+            m_journal->state(redemption.id) != RedemptionJournal::Seen) {
+            qDebug() << "Skipping already handled redemption:" << redemption.id;
+            continue;
+        }
+        unseen.append(redemption);
+    }
+    if (!unseen.isEmpty()) {
+        emitRedemptions(unseen);
+    }
+}
+
+bool TwitchManager::claim(const Redemption &redemption)
+{
+    // the journal remembers for longer than the dedup window does, anything
+    // resumed from it is still only seen there and can be claimed again
+    if (!m_seen.insert(redemption.id) ||
+        m_journal->state(redemption.id) != RedemptionJournal::Seen) {
+        return false;
+    }
+    m_journal->record(redemption.rewardId, redemption.id, RedemptionJournal::Seen);
+    return true;
+}
+
+void TwitchManager::emitRedemptions(const QList<Redemption> &redemptions)
+{
+    // devices first, the maps are only built if something in qml listens
+    emit redemptionsReady(redemptions);
+    if (isSignalConnected(QMetaMethod::fromSignal(&TwitchManager::gotRedemptions))) {
+        QList<QVariantMap> maps;
+        maps.reserve(redemptions.size());
+        for (const Redemption &redemption : redemptions) {
+            maps.append(redemption.toVariantMap());
+        }
+        emit gotRedemptions(maps);
+    }
+}
+
+void TwitchManager::resumeJournal(const QHash<QString, RedemptionJournal::Entry> &entries)
+{
+    QList<Redemption> undispatched;
+    for (const RedemptionJournal::Entry &entry : entries) {
+        switch (entry.state) {
+        case RedemptionJournal::Seen: {
+            // we never got as far as the device, so it still needs doing
+            qInfo() << "Resuming undispatched redemption:" << entry.id;
+            Redemption redemption;
+            redemption.id = entry.id;
+            redemption.broadcasterId = m_userId;
+            redemption.status = u"UNFULFILLED"_qs;
+            redemption.rewardId = entry.rewardId;
+            undispatched.append(redemption);
+            break;
+        }
+        case RedemptionJournal::Dispatched: {
+            // the device may or may not have gone off, doing it twice is
+            // worse than missing it so it's treated as done
+            qWarning() << "Redemption was dispatched but never acked:" << entry.id;
+            queueRedemptionUpdate(entry.rewardId, entry.id, u"FULFILLED"_qs);
+            break;
+        }
+        case RedemptionJournal::Acked: {
+            qInfo() << "Resuming fulfillment of redemption:" << entry.id;
+            queueRedemptionUpdate(entry.rewardId, entry.id, u"FULFILLED"_qs);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    if (!undispatched.isEmpty()) {
+        emitRedemptions(undispatched);
+    }
 }
@@ -2,9 +2,17 @@
 #define TWITCHMANAGER_H
 
 #include <QObject>
-#include <QtQml>
 
+#include "eventsubclient.h"
+#include "helixscheduler.h"
+#include "qmlsupport.h"
 #include "qtutils.h"
+#include "redemptiondeduper.h"
+#include "redemptionjournal.h"
+#include "rewardcache.h"
+#include "rewardmodel.h"
+#include "sessionstore.h"
+#include "twitchtypes.h"
 
 class TwitchManager : public QObject
 {
@@ -27,18 +35,88 @@ class TwitchManager : public QObject
     // for fetching a list of redemptions for a specific reward
     inline const static QUrl RedemptionsUrl{
         u"https://api.twitch.tv/helix/channel_points/custom_rewards/redemptions"_qs};
+    // for subscribing to eventsub topics
+    inline const static QUrl SubscriptionsUrl{
+        u"https://api.twitch.tv/helix/eventsub/subscriptions"_qs};
+    // helix accepts up to 50 redemption ids per update
+    inline const static int MaxRedemptionIds{50};
+    // validating more often than this is pointless, less often is an audit
+    inline const static int ValidateInterval{60 * 60};
+    // refresh this many seconds ahead of the token expiring, plus the
+    // session's jitter
+    inline const static int RefreshLead{5 * 60};
+    // times a helix request is replayed after a 401 before giving up on it
+    inline const static int MaxAuthRetries{2};
+    // requests sent this close to expiry kick off a refresh right away
+    inline const static int ExpiryMargin{30};
+    // most redemptions helix will return in a single page
+    inline const static int RedemptionPageSize{50};
+    // upper bound on pages followed in one sync, guards against a bad cursor
+    inline const static int MaxSyncPages{20};
+    // titles of the rewards that drive the devices
+    inline const static QString ShockRewardTitle{u"Shock The Streamer"_qs};
+    inline const static QString SmokeRewardTitle{u"Hotbox The Streamer"_qs};
     // current scopes we actually use
     inline const static QList<QString> Scopes{u"moderator:manage:announcements"_qs,
                                               u"channel:manage:redemptions"_qs};
 
-    explicit TwitchManager(QObject *parent = nullptr);
+    // every request we send is one of these, used for tracking what's busy
+    enum RequestKind {
+        Authorize,
+        Validate,
+        Refresh,
+        Revoke,
+        GetRewards,
+        CreateReward,
+        UpdateReward,
+        GetRedemptions,
+        UpdateRedemptions,
+        Subscribe,
+    };
+    Q_ENUM(RequestKind)
+
+    // channels other than the default one keep their files in a directory of
+    // their own, a scheduler is made for us if none is shared with us
+    explicit TwitchManager(HelixScheduler *scheduler = nullptr, const QString &channel = {},
+                           QObject *parent = nullptr);
+    ~TwitchManager();
+    // whether a login callback carries the state we handed out
+    bool expectsCallback(const QUrl &url) const;
     void handleCallback(const QUrl &url);
+    void useEventSubStandIn(const QUrl &url);
+    // sends the oauth and helix requests to a local stand-in instead
+    void useTwitchStandIn(const QUrl &url);
+    // for whoever acts on a redemption, journals it as seen and returns false
+    // if it was already claimed
+    bool claim(const Redemption &redemption);
+
+    const QString &channel() const { return m_channel; }
+    EventSubClient *eventSub() const { return m_eventSub; }
+    HelixScheduler *scheduler() const { return m_scheduler; }
+    RedemptionJournal *journal() const { return m_journal; }
+    RewardModel *rewards() const { return m_rewards; }
+    // invalid until a validate succeeds, and again after logging out
+    const QDateTime &validatedAt() const { return m_validatedAt; }
 
   signals:
     void validated();
+    // no session to validate or it was turned down, a retry may follow
+    void validateFailed();
+    void gotRewards();
+    // the fetch came back without any, the cached ones are all we have
+    void rewardsFailed();
+    // typed for the router, the maps are for qml
+    void redemptionsReady(const QList<Redemption> &redemptions);
     void gotRedemptions(QList<QVariantMap> redemptions);
+    void redemptionUpdated(const QString &rewardId, const QString &id, const QString &status,
+                           bool success);
+    // a token refresh came back, whether we got usable tokens out of it
+    void refreshed(bool success);
 
   public slots:
+    void save();
+    void cancel(const quint64 &id);
+    void validate(const bool &force = false);
     void refresh();
     void login(const bool &forceVerify = false);
     void logout();
@@ -47,39 +125,134 @@ class TwitchManager : public QObject
     void createReward(const QVariantMap &data);
     void updateReward(const QVariantMap &data);
     void getRedemptions(const QVariantMap &params);
+    void syncRedemptions(const QString &rewardId);
     void updateRedemption(const QString &rewardId, const QString &id, const QString &status);
+    void queueRedemptionUpdate(const QString &rewardId, const QString &id, const QString &status);
+    void flushRedemptionUpdates();
 
   private slots:
-    void validate(const bool &force = false);
-    void validateFinished();
-    void authorizeFinished();
-    void refreshFinished();
-    void logoutFinished();
+    void authTimeout();
+    void validateFinished(QNetworkReply *reply);
+    void authorizeFinished(QNetworkReply *reply);
+    void refreshFinished(QNetworkReply *reply);
+    void logoutFinished(QNetworkReply *reply);
+
+    void getRewardsFinished(QNetworkReply *reply);
+    void createRewardFinished(QNetworkReply *reply);
+    void updateRewardFinished(QNetworkReply *reply);
+    void getRedemptionsFinished(QNetworkReply *reply);
+    void syncRedemptionsFinished(QNetworkReply *reply, const QString &rewardId);
+    void updateRedemptionFinished(QNetworkReply *reply, const QString &rewardId,
+                                  const QList<QString> &ids, const QString &newStatus);
 
-    void getRewardsFinished();
-    void createRewardFinished();
-    void updateRewardFinished();
-    void getRedemptionsFinished();
-    void updateRedemptionFinished();
+    void eventSubWelcomed(const QString &sessionId, bool handover);
+    void eventSubRedemption(const QJsonObject &event);
+    void subscribeFinished(QNetworkReply *reply);
+
+    void rewardChanged(const QString &id);
 
   private:
-    QNetworkAccessManager *m_nam;
-    QTimer *m_validateTimer;
+    Q_PROPERTY(QString channel READ channel CONSTANT)
+    Q_PROPERTY(EventSubClient *eventSub READ eventSub CONSTANT)
+    Q_PROPERTY(HelixScheduler *scheduler READ scheduler CONSTANT)
+    Q_PROPERTY(RewardModel *rewards READ rewards CONSTANT)
+
+    struct InFlightRequest {
+        quint64 id;
+        RequestKind kind;
+        QElapsedTimer started;
+        // scheduler ticket used to cancel the request
+        quint64 ticket = 0;
+        // everything needed to send it again after a refresh
+        QNetworkRequest request;
+        QByteArray verb;
+        QByteArray body;
+        HelixScheduler::Handler handler;
+        // run instead of the handler when it is dropped without a reply, so
+        // whoever is waiting on it hears that it failed
+        std::function<void()> abandoned;
+        int authRetries = 0;
+        // waiting on a refresh instead of the scheduler
+        bool parked = false;
+    };
+
+    // incremental sync state for a single reward, the mark is the newest
+    // redemption we have already handed out so later syncs can stop there
+    struct RedemptionSync {
+        bool running = false;
+        int pages = 0;
+        QString markId;
+        QDateTime markAt;
+        QString nextMarkId;
+        QDateTime nextMarkAt;
+    };
+
+    QString m_channel;
+    HelixScheduler *m_scheduler;
+    EventSubClient *m_eventSub;
+    bool m_eventSubStandIn;
+    QUrl m_standInUrl;
+    SessionStore *m_session;
+    RewardModel *m_rewards;
+    RewardCache *m_rewardCache;
+    QTimer *m_authTimer;
+    QDateTime m_validatedAt;
+    QTimer *m_updateTimer;
     QString m_expectedState;
+    // queued redemption ids keyed by reward id and status
+    QMap<QPair<QString, QString>, QList<QString>> m_pendingUpdates;
+    QHash<QString, RedemptionSync> m_syncs;
+    RedemptionDeduper m_seen;
+    RedemptionJournal *m_journal;
+    QHash<quint64, InFlightRequest> m_requests;
+    quint64 m_nextRequestId;
 
     QString m_accessToken;
     QString m_userId;
 
+    quint64 send(const RequestKind &kind, const QNetworkRequest &request, const QByteArray &verb,
+                 const QByteArray &body, HelixScheduler::Handler handler,
+                 std::function<void()> abandoned = {});
+    static HelixScheduler::Priority priority(const RequestKind &kind);
+    void dispatch(const quint64 &id);
+    void finished(const quint64 &id, QNetworkReply *reply);
+    void replayParked();
+    void dropParked();
+    bool isInFlight(const QList<RequestKind> &kinds) const;
+    void updateBusy();
     void updateLoggedIn();
+    static QDateTime expiresAt(const QJsonObject &response);
+    QDateTime refreshAt() const;
+    void scheduleAuth();
     bool validateScopes(const QJsonArray &scopes) const;
+    void requestRedemptionPage(const QString &rewardId, const QString &cursor);
+    void finishSync(const QString &rewardId, const bool &success);
+    static void stamp(QList<Redemption> &redemptions, const qint64 &fetchedAt);
+    void handOut(const QList<Redemption> &redemptions);
+    void emitRedemptions(const QList<Redemption> &redemptions);
+    void resumeJournal(const QHash<QString, RedemptionJournal::Entry> &entries);
+    void sendRedemptionUpdate(const QString &rewardId, const QList<QString> &ids,
+                              const QString &status);
+    QUrl endpoint(const QUrl &url) const;
+    static QString dataPath(const QString &channel);
     inline QNetworkRequest createRequest(const QUrl &url) const;
 
+    // loading is true while anything at all is in flight, the rest narrow it
+    // down to what kind of request is outstanding
     RO_PROP(bool, loading, setLoading)
+    RO_PROP(int, inFlight, setInFlight)
+    RO_PROP(bool, authorizing, setAuthorizing)
+    RO_PROP(bool, fetchingRewards, setFetchingRewards)
+    RO_PROP(bool, updatingRewards, setUpdatingRewards)
+    RO_PROP(bool, fetchingRedemptions, setFetchingRedemptions)
+    RO_PROP(bool, updatingRedemptions, setUpdatingRedemptions)
     RO_PROP(bool, loggedIn, setLoggedIn)
     RW_PROP(bool, autoLogin, setAutoLogin)
 
     RO_PROP(QString, userName, setUserName)
-    RO_PROP(QList<QVariantMap>, rewards, setRewards)
+    // the device rewards, empty until they show up in the reward list
+    RO_PROP(QVariant, shockReward, setShockReward)
+    RO_PROP(QVariant, smokeReward, setSmokeReward)
 };
 
 #endif // TWITCHMANAGER_H
@@ -0,0 +1,77 @@
+#include "twitchtypes.h"
+
+Reward Reward::fromJson(const QJsonObject &obj)
+{
+    Reward reward;
+    reward.id = obj.value(u"id"_qs).toString();
+    reward.title = obj.value(u"title"_qs).toString();
+    reward.prompt = obj.value(u"prompt"_qs).toString();
+    reward.cost = obj.value(u"cost"_qs).toInt();
+    reward.isEnabled = obj.value(u"is_enabled"_qs).toBool();
+    reward.isPaused = obj.value(u"is_paused"_qs).toBool();
+    reward.skipQueue = obj.value(u"should_redemptions_skip_request_queue"_qs).toBool();
+    const QJsonObject cooldown = obj.value(u"global_cooldown_setting"_qs).toObject();
+    if (cooldown.value(u"is_enabled"_qs).toBool()) {
+        reward.cooldownSeconds = cooldown.value(u"global_cooldown_seconds"_qs).toInt();
+    }
+    return reward;
+}
+
+QJsonObject Reward::toJson() const
+{
+    return {
+        {u"id"_qs, id},
+        {u"title"_qs, title},
+        {u"prompt"_qs, prompt},
+        {u"cost"_qs, cost},
+        {u"is_enabled"_qs, isEnabled},
+        {u"is_paused"_qs, isPaused},
+        {u"should_redemptions_skip_request_queue"_qs, skipQueue},
+        {u"global_cooldown_setting"_qs,
+         QJsonObject{{u"is_enabled"_qs, cooldownSeconds > 0},
+                     {u"global_cooldown_seconds"_qs, cooldownSeconds}}},
+    };
+}
+
+bool Reward::operator==(const Reward &other) const
+{
+    return id == other.id && title == other.title && prompt == other.prompt &&
+           cost == other.cost && isEnabled == other.isEnabled && isPaused == other.isPaused &&
+           skipQueue == other.skipQueue && cooldownSeconds == other.cooldownSeconds;
+}
+
+Redemption Redemption::fromJson(const QJsonObject &obj)
+{
+    Redemption redemption;
+    redemption.id = obj.value(u"id"_qs).toString();
+    // eventsub prefixes the broadcaster fields with broadcaster_user
+    redemption.broadcasterId = obj.contains(u"broadcaster_user_id"_qs)
+                                   ? obj.value(u"broadcaster_user_id"_qs).toString()
+                                   : obj.value(u"broadcaster_id"_qs).toString();
+    redemption.userId = obj.value(u"user_id"_qs).toString();
+    redemption.userLogin = obj.value(u"user_login"_qs).toString();
+    redemption.userName = obj.value(u"user_name"_qs).toString();
+    redemption.userInput = obj.value(u"user_input"_qs).toString();
+    redemption.status = obj.value(u"status"_qs).toString().toUpper();
+    const QJsonObject reward = obj.value(u"reward"_qs).toObject();
+    redemption.rewardId = reward.value(u"id"_qs).toString();
+    redemption.rewardTitle = reward.value(u"title"_qs).toString();
+    redemption.redeemedAt =
+        QDateTime::fromString(obj.value(u"redeemed_at"_qs).toString(), Qt::ISODateWithMs);
+    return redemption;
+}
+
+QVariantMap Redemption::toVariantMap() const
+{
+    return {
+        {u"id"_qs, id},
+        {u"broadcaster_id"_qs, broadcasterId},
+        {u"user_id"_qs, userId},
+        {u"user_login"_qs, userLogin},
+        {u"user_name"_qs, userName},
+        {u"user_input"_qs, userInput},
+        {u"status"_qs, status},
+        {u"reward"_qs, QVariantMap{{u"id"_qs, rewardId}, {u"title"_qs, rewardTitle}}},
+        {u"redeemed_at"_qs, redeemedAt.toString(Qt::ISODateWithMs)},
+    };
+}
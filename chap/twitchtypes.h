@@ -0,0 +1,66 @@
+#ifndef TWITCHTYPES_H
+#define TWITCHTYPES_H
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QObject>
+
+#include "qmlsupport.h"
+
+// custom channel point reward, the parts of it we actually use
+// see https://dev.twitch.tv/docs/api/reference/#get-custom-reward
+struct Reward {
+    Q_GADGET
+    QML_VALUE_TYPE(reward)
+    Q_PROPERTY(QString id MEMBER id)
+    Q_PROPERTY(QString title MEMBER title)
+    Q_PROPERTY(QString prompt MEMBER prompt)
+    Q_PROPERTY(int cost MEMBER cost)
+    Q_PROPERTY(bool isEnabled MEMBER isEnabled)
+    Q_PROPERTY(bool isPaused MEMBER isPaused)
+    Q_PROPERTY(bool skipQueue MEMBER skipQueue)
+    Q_PROPERTY(int cooldownSeconds MEMBER cooldownSeconds)
+
+  public:
+    QString id;
+    QString title;
+    QString prompt;
+    int cost = 0;
+    bool isEnabled = false;
+    bool isPaused = false;
+    bool skipQueue = false;
+    // zero when the global cooldown is off
+    int cooldownSeconds = 0;
+
+    static Reward fromJson(const QJsonObject &obj);
+    // helix shaped, only what we keep
+    QJsonObject toJson() const;
+    bool operator==(const Reward &other) const;
+    bool operator!=(const Reward &other) const { return !(*this == other); }
+};
+
+// a single redemption of a reward, from helix or eventsub
+// see https://dev.twitch.tv/docs/api/reference/#get-custom-reward-redemption
+struct Redemption {
+    QString id;
+    QString broadcasterId;
+    QString userId;
+    QString userLogin;
+    QString userName;
+    QString userInput;
+    // always uppercase, eventsub sends it lowercase
+    QString status;
+    QString rewardId;
+    QString rewardTitle;
+    QDateTime redeemedAt;
+    // when the reply or event carrying it came in and when it was parsed,
+    // steadyMicros(), zero for redemptions that didn't come from twitch
+    qint64 fetchedAt = 0;
+    qint64 parsedAt = 0;
+
+    static Redemption fromJson(const QJsonObject &obj);
+    // helix shaped map for handing to qml
+    QVariantMap toVariantMap() const;
+};
+
+#endif // TWITCHTYPES_H